@@ -0,0 +1,104 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace Engine {
+
+// Time in integer nanoseconds. Differences and sums are exact, and 63 bits
+// last for centuries, so time is kept in Ticks and converted to seconds only
+// where it enters a formula.
+using Ticks = int64_t;
+
+constexpr Ticks TicksPerSecond = 1'000'000'000;
+
+constexpr double seconds(Ticks ticks) {
+    return double(ticks) / double(TicksPerSecond);
+}
+
+// Rounded to the nearest tick.
+constexpr Ticks ticks(double seconds) {
+    return Ticks(seconds * double(TicksPerSecond) + (seconds < 0 ? -0.5 : 0.5));
+}
+
+// Monotonic time source.
+struct Clock {
+    virtual ~Clock() = default;
+
+    virtual Ticks now() const = 0;
+};
+
+// The wall clock, counted from construction.
+class SteadyClock : public Clock {
+public:
+    Ticks now() const override {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _epoch).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point _epoch = std::chrono::steady_clock::now();
+};
+
+// Time that moves only when told to, so a simulation can run as fast as it
+// computes and the same way every run.
+class VirtualClock : public Clock {
+public:
+    explicit VirtualClock(Ticks start = 0)
+    : _now(start) {}
+
+    Ticks now() const override {
+        return _now;
+    }
+
+    void advance(Ticks delta) {
+        _now += delta > 0 ? delta : 0;
+    }
+
+private:
+    Ticks _now;
+};
+
+// What a scene callback knows about the frame it runs in. Sampled once per
+// frame, so everything handled in the frame agrees on the time.
+struct FrameContext {
+    // Since the clock's epoch.
+    Ticks time;
+    // Since the previous frame, 0 for the first.
+    Ticks delta;
+    // Counted from 0, the frame onInit runs in.
+    uint64_t frame;
+
+    double seconds() const {
+        return Engine::seconds(time);
+    }
+
+    double deltaSeconds() const {
+        return Engine::seconds(delta);
+    }
+};
+
+// Turns clock readings into FrameContexts. A reading earlier than the
+// previous one, which a misbehaving source could give, counts as no time.
+class FrameTimer {
+public:
+    // Restarts the count at frame 0, e.g. when a scene is initialized.
+    FrameContext start(Ticks now) {
+        _context = FrameContext{now, 0, 0};
+        return _context;
+    }
+
+    FrameContext tick(Ticks now) {
+        const auto time = now > _context.time ? now : _context.time;
+        _context = FrameContext{time, time - _context.time, _context.frame + 1};
+        return _context;
+    }
+
+    const FrameContext& current() const {
+        return _context;
+    }
+
+private:
+    FrameContext _context{};
+};
+
+} /* namespace Engine */
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <simd/simd.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+
+#include "./FrameArena.hh"
+
+namespace Engine {
+
+// Same values as MTL::PrimitiveType.
+enum class PrimitiveType: uint8_t {
+    Point,
+    Line,
+    LineStrip,
+    Triangle,
+    TriangleStrip
+};
+
+// Index into the pipeline states the backend replays with; each scene
+// numbers its own.
+using PipelineId = uint8_t;
+
+// Vertex buffer slots a backend binds the data of draw commands to. Bytes
+// commands name their slot themselves.
+struct Bindings {
+    uint8_t vertices;
+    uint8_t color;
+    uint8_t instances;
+};
+
+// Byte range in a command list's arena.
+struct ArenaSpan {
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct Command {
+    enum class Type: uint8_t {
+        // Binds data to vertex buffer slot for the following draws, e.g. uniforms.
+        Bytes,
+        // Draws vertexCount vertices from data, instanceCount times if
+        // instanced, the records at instances going to the instance slot.
+        Draw
+    };
+
+    // Defaults for the fields a command of the other type leaves out.
+    Type type = Type::Draw;
+    PrimitiveType primitive = PrimitiveType::Triangle;
+    PipelineId pipeline = 0;
+    uint8_t slot = 0;
+    ArenaSpan data{};
+    ArenaSpan instances{};
+    uint32_t vertexCount = 0;
+    uint32_t instanceCount = 0;
+    simd::float3 color{};
+};
+
+// Draw calls of one frame, recorded by scenes without any graphics API and
+// replayed by a backend. Commands and the bytes they reference live in
+// storage allocated once at construction; reset() rewinds it for the next
+// frame. Recording past the capacity drops the command and counts it.
+//
+// Vertices built for a draw can be written straight into the list's arena
+// with allocate(); recording a span that is already there does not copy it.
+class CommandList {
+public:
+    struct Stats {
+        uint32_t commands;
+        uint32_t draws;
+        uint32_t vertices;
+        uint32_t instances;
+        uint32_t bytes;
+        uint32_t dropped;
+    };
+
+    explicit CommandList(size_t commandCapacity = 4096, size_t arenaCapacity = 1 << 20)
+    : _commands(new Command[commandCapacity]),
+      _arena(arenaCapacity),
+      _commandCapacity(commandCapacity) {}
+
+    void reset() {
+        _count = 0;
+        _arena.reset();
+        _stats = {};
+    }
+
+    std::span<const Command> commands() const {
+        return {_commands.get(), _count};
+    }
+
+    const FrameArena& arena() const {
+        return _arena;
+    }
+
+    // Space for count Ts that lives until reset(), to fill and then record.
+    // Empty when the arena is full.
+    template <class T>
+    std::span<T> allocate(size_t count) {
+        return _arena.allocate<T>(count);
+    }
+
+    template <class T = std::byte>
+    std::span<const T> view(ArenaSpan span) const {
+        return {reinterpret_cast<const T*>(_arena.data() + span.offset), span.size / sizeof(T)};
+    }
+
+    const Stats& stats() const {
+        return _stats;
+    }
+
+    // Copies bytes into the arena and binds them to the vertex buffer slot.
+    bool bytes(uint8_t slot, const void* data, size_t size) {
+        ArenaSpan span;
+        if (!copy(data, size, span)) {
+            return drop();
+        }
+        return push(Command{.type = Command::Type::Bytes, .slot = slot, .data = span});
+    }
+
+    template <class T>
+    bool bytes(uint8_t slot, const T& value) {
+        return bytes(slot, &value, sizeof(T));
+    }
+
+    template <class Vertex>
+    bool draw(PipelineId pipeline,
+              PrimitiveType primitive,
+              std::span<const Vertex> vertices,
+              const simd::float3& color
+              ) {
+        ArenaSpan data;
+        if (!copy(vertices.data(), vertices.size_bytes(), data)) {
+            return drop();
+        }
+        _stats.draws++;
+        _stats.vertices += vertices.size();
+        return push(Command{
+            .type = Command::Type::Draw,
+            .primitive = primitive,
+            .pipeline = pipeline,
+            .data = data,
+            .vertexCount = (uint32_t)vertices.size(),
+            .color = color,
+        });
+    }
+
+    // Draws the mesh once per instance. An empty mesh draws vertexCount
+    // vertices that the shader builds from the instance alone.
+    template <class Vertex, class Instance>
+    bool drawInstanced(PipelineId pipeline,
+                       PrimitiveType primitive,
+                       std::span<const Vertex> mesh,
+                       std::span<const Instance> instances,
+                       uint32_t vertexCount
+                       ) {
+        ArenaSpan data, records;
+        if (!copy(mesh.data(), mesh.size_bytes(), data) ||
+            !copy(instances.data(), instances.size_bytes(), records)) {
+            return drop();
+        }
+        _stats.draws++;
+        _stats.vertices += vertexCount * instances.size();
+        _stats.instances += instances.size();
+        return push(Command{
+            .type = Command::Type::Draw,
+            .primitive = primitive,
+            .pipeline = pipeline,
+            .data = data,
+            .instances = records,
+            .vertexCount = vertexCount,
+            .instanceCount = (uint32_t)instances.size(),
+        });
+    }
+
+private:
+    bool copy(const void* data, size_t size, ArenaSpan& span) {
+        if (size && _arena.owns(data)) {
+            span = ArenaSpan{(uint32_t)_arena.offset(data), (uint32_t)size};
+            _stats.bytes = (uint32_t)_arena.stats().used;
+            return true;
+        }
+        const auto bytes = _arena.allocate(size);
+        if (bytes.size() != size) {
+            return false;
+        }
+        if (size) {
+            std::memcpy(bytes.data(), data, size);
+        }
+        span = ArenaSpan{(uint32_t)_arena.offset(bytes.data()), (uint32_t)size};
+        _stats.bytes = (uint32_t)_arena.stats().used;
+        return true;
+    }
+
+    bool push(const Command& command) {
+        if (_count == _commandCapacity) {
+            return drop();
+        }
+        _commands[_count++] = command;
+        _stats.commands++;
+        return true;
+    }
+
+    bool drop() {
+        _stats.dropped++;
+        return false;
+    }
+
+    std::unique_ptr<Command[]> _commands;
+    FrameArena _arena;
+    size_t _commandCapacity;
+    size_t _count = 0;
+    Stats _stats{};
+};
+
+} /* namespace Engine */
@@ -4,7 +4,9 @@
 #include <CoreGraphics/CoreGraphics.h>
 #include <MetalKit/MetalKit.hpp>
 
+#include "./Clock.hh"
 #include "./Input.hh"
+#include "./CommandList.hh"
 
 #define INLINE _MTL_INLINE
 
@@ -14,8 +16,13 @@ struct Renderer : public MTK::ViewDelegate {};
 
 struct Scene {
     virtual Engine::Renderer* createRenderer(MTK::View *mtkView) = 0;
-    virtual void onIdle(CFTimeInterval time) = 0;
-    virtual void onInit(CFTimeInterval time) = 0;
+    
+    // Advance the simulation to frame.time. Runs once per frame, off the main
+    // thread.
+    virtual void onIdle(const FrameContext& frame) = 0;
+    
+    // Reset the scene. Runs before the first onIdle with frame 0.
+    virtual void onInit(const FrameContext& frame) = 0;
     
     // Handle mouse click event. Coordinates are in pixels increasing from the
     // lower left corner to the top and to the right.
@@ -31,6 +38,10 @@ struct Scene {
     // Handle physical keyboard event. Return boolean indicating whether the key was handled.
     virtual bool onKey(Engine::Input::KeyboardButton button, Engine::Input::ButtonState state) = 0;
     
+    // Record the frame's draws. Replayed by the Metal renderer or, headless,
+    // by the software rasterizer.
+    virtual void onDraw(CommandList& commands) = 0;
+    
     virtual ~Scene() {};
 };
 
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+
+#include "./Clock.hh"
+
+namespace Engine {
+
+// Steps a simulation at a fixed rate however the frames fall. Each frame's
+// delta goes into an accumulator and whole steps are taken out of it; what
+// is left over, as a fraction of a step, is how far to interpolate between
+// the last two simulated states when drawing.
+//
+//     fixed.advance(frame.delta, [](Engine::Ticks t) {
+//         previous = current;
+//         simulate(current, t);
+//     });
+//     draw(mix(previous, current, fixed.alpha()));
+//
+// A frame takes at most maxSteps steps and the time beyond them is dropped,
+// so a simulation that cannot keep up slows down rather than falling further
+// behind every frame.
+class FixedStep {
+public:
+    struct Stats {
+        uint64_t steps;
+        // Frames that hit maxSteps, and the time they dropped.
+        uint64_t clampedFrames;
+        Ticks dropped;
+    };
+
+    FixedStep(Ticks step, unsigned maxSteps)
+    : _step(step),
+      _maxSteps(maxSteps) {}
+
+    // Restarts the simulation at time with nothing accumulated.
+    void reset(Ticks time) {
+        _time = time;
+        _accumulator = 0;
+    }
+
+    // Adds delta and calls step(t) for each whole step it completes, t being
+    // the time the step starts at. Returns the number of steps taken.
+    template <class F>
+    unsigned advance(Ticks delta, F&& step) {
+        _accumulator += delta > 0 ? delta : 0;
+        const Ticks limit = _step * _maxSteps;
+        if (_accumulator > limit) {
+            _stats.clampedFrames++;
+            _stats.dropped += _accumulator - limit;
+            _accumulator = limit;
+        }
+        unsigned steps = 0;
+        for (; _accumulator >= _step; _accumulator -= _step, _time += _step) {
+            step(_time);
+            steps++;
+        }
+        _stats.steps += steps;
+        return steps;
+    }
+
+    // How far past the last step the frame is, in steps, in [0, 1).
+    float alpha() const {
+        return float(double(_accumulator) / double(_step));
+    }
+
+    // The time simulated up to.
+    Ticks time() const {
+        return _time;
+    }
+
+    Ticks step() const {
+        return _step;
+    }
+
+    const Stats& stats() const {
+        return _stats;
+    }
+
+private:
+    Ticks _step;
+    unsigned _maxSteps;
+    Ticks _time = 0;
+    Ticks _accumulator = 0;
+    Stats _stats{};
+};
+
+} /* namespace Engine */
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+
+namespace Engine {
+
+// Bump allocator for data that lives for one frame, such as vertices built
+// while recording draws. The storage is allocated once at construction;
+// allocating moves a pointer and reset() rewinds it, so a frame does no heap
+// allocation however many spans it takes. Requests that do not fit fail
+// with an empty span and are counted.
+class FrameArena {
+public:
+    struct Stats {
+        // Bytes allocated since reset(), padding included.
+        size_t used;
+        // Largest used, plus what failed to fit, of any frame so far: the
+        // capacity that would have served every frame.
+        size_t highWater;
+        // Allocations since reset() that did not fit.
+        uint32_t failed;
+    };
+
+    // Every allocation is aligned for simd::float4x4.
+    static constexpr size_t Alignment = 16;
+
+    explicit FrameArena(size_t capacity)
+    : _data(new (std::align_val_t(Alignment)) std::byte[capacity]),
+      _capacity(capacity) {}
+
+    void reset() {
+        _stats.used = 0;
+        _stats.failed = 0;
+        _overflow = 0;
+    }
+
+    // Uninitialized space for count Ts, empty if it does not fit.
+    template <class T = std::byte>
+    std::span<T> allocate(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena memory is reused without running destructors");
+        static_assert(alignof(T) <= Alignment);
+        const size_t size = count * sizeof(T);
+        const size_t offset = (_stats.used + Alignment - 1) & ~(Alignment - 1);
+        if (size > _capacity - std::min(offset, _capacity)) {
+            _stats.failed++;
+            _overflow += size;
+            _stats.highWater = std::max(_stats.highWater, offset + _overflow);
+            return {};
+        }
+        _stats.used = offset + size;
+        _stats.highWater = std::max(_stats.highWater, _stats.used + _overflow);
+        return {reinterpret_cast<T*>(_data.get() + offset), count};
+    }
+
+    // Whether p points into the arena, i.e. came from allocate().
+    bool owns(const void* p) const {
+        const auto byte = static_cast<const std::byte*>(p);
+        return byte >= _data.get() && byte < _data.get() + _capacity;
+    }
+
+    size_t offset(const void* p) const {
+        return static_cast<const std::byte*>(p) - _data.get();
+    }
+
+    const std::byte* data() const {
+        return _data.get();
+    }
+
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    const Stats& stats() const {
+        return _stats;
+    }
+
+private:
+    struct AlignedDelete {
+        void operator()(std::byte* p) const {
+            ::operator delete[](p, std::align_val_t(Alignment));
+        }
+    };
+
+    std::unique_ptr<std::byte[], AlignedDelete> _data;
+    size_t _capacity;
+    // Bytes of this frame's failed allocations.
+    size_t _overflow = 0;
+    Stats _stats{};
+};
+
+} /* namespace Engine */
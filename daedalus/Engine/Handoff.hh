@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Lock-free handoff between the thread running Scene::onIdle (the
+// CVDisplayLink thread in the app) and the one running input callbacks and
+// onDraw (the main thread): input goes to the simulation through a Mailbox,
+// state comes back as snapshots in a TripleBuffer. Neither side ever waits
+// for the other.
+namespace Engine {
+
+// Latest-value handoff from one producer to one consumer. The producer fills
+// back() and publishes it; the consumer's read() returns the most recently
+// published value, which stays untouched until its next read(). Values
+// published in between are skipped, never torn.
+template <class T>
+class TripleBuffer {
+public:
+    // The slot to fill. It holds the value published two or more
+    // publishes ago, so overwrite it completely.
+    T& back() {
+        return _slots[_back].value;
+    }
+
+    void publish() {
+        _back = _middle.exchange(_back | Fresh, std::memory_order_acq_rel) & Index;
+    }
+
+    // Same value as the previous call when nothing was published since.
+    const T& read() {
+        if (_middle.load(std::memory_order_relaxed) & Fresh) {
+            _front = _middle.exchange(_front, std::memory_order_acq_rel) & Index;
+        }
+        return _slots[_front].value;
+    }
+
+private:
+    static constexpr uint8_t Index = 3;
+    static constexpr uint8_t Fresh = 4;
+
+    // Each on its own cache line so the two threads do not share any.
+    struct alignas(64) Slot {
+        T value{};
+    };
+
+    std::array<Slot, 3> _slots{};
+    alignas(64) uint8_t _back = 0;
+    alignas(64) std::atomic<uint8_t> _middle = 1;
+    alignas(64) uint8_t _front = 2;
+};
+
+// Bounded queue from one producer to one consumer. Pushing into a full
+// mailbox fails rather than waits.
+template <class T, size_t Capacity>
+class Mailbox {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Mailbox capacity must be a power of two");
+
+public:
+    bool push(const T& item) {
+        const auto tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) == Capacity) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _items[tail & (Capacity - 1)] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Calls f on every item pushed so far, oldest first.
+    template <class F>
+    void drain(F&& f) {
+        auto head = _head.load(std::memory_order_relaxed);
+        const auto tail = _tail.load(std::memory_order_acquire);
+        for (; head != tail; ++head) {
+            f(_items[head & (Capacity - 1)]);
+        }
+        _head.store(head, std::memory_order_release);
+    }
+
+    size_t dropped() const {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::array<T, Capacity> _items{};
+    alignas(64) std::atomic<size_t> _head = 0;
+    alignas(64) std::atomic<size_t> _tail = 0;
+    std::atomic<size_t> _dropped = 0;
+};
+
+} /* namespace Engine */
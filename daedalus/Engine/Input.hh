@@ -1,5 +1,7 @@
 #pragma once
 
+#include <simd/simd.h>
+
 namespace Engine {
 namespace Input {
 
@@ -131,5 +133,17 @@ enum class MouseButton {
     Left, Right
 };
 
+// Arguments of a Scene input callback, for handling the input later or on
+// another thread. Clicks and keys use state, mouse events position.
+struct Event {
+    enum class Type { MouseClick, MouseMove, Key };
+    
+    Type type;
+    simd::float2 position{};
+    MouseButton button = MouseButton::Left;
+    KeyboardButton key{};
+    ButtonState state = ButtonState::Down;
+};
+
 } /* namespace Input */
 } /* namespace Engine */
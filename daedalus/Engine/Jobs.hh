@@ -0,0 +1,437 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Work-stealing thread pool for per-frame work.
+//
+//     auto& jobs = Engine::JobSystem::shared();
+//     jobs.parallelFor(0, count, 64, [&](size_t begin, size_t end) {
+//         for (size_t i = begin; i < end; ++i) { ... }
+//     });
+//
+// Every worker owns a deque it pushes to and pops from at the bottom while
+// idle workers steal from the top. Tasks submitted from other threads go to
+// a shared queue. A thread that waits runs queued tasks until what it waits
+// for is done, so waiting from a task or from the main thread never leaves a
+// core idle and nested parallelFor calls cannot deadlock.
+namespace Engine {
+
+namespace detail {
+    struct Task {
+        std::function<void()> work{};
+        // One for the queue or the continuation list holding the task, one
+        // for every Handle.
+        std::atomic<uint32_t> refs = 1;
+        // Tasks this one is a continuation of that have not finished.
+        std::atomic<uint32_t> dependencies = 0;
+        std::atomic<bool> done = false;
+        std::mutex lock{};
+        std::vector<Task*> continuations{};
+
+        void retain() {
+            refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void release() {
+            if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete this;
+            }
+        }
+    };
+
+    // Chase-Lev deque as corrected for weak memory models by Lê et al.,
+    // with a fixed capacity: a push that does not fit fails and the caller
+    // runs the task right away.
+    class TaskDeque {
+    public:
+        static constexpr int64_t Capacity = 4096;
+
+        // Owner only.
+        bool push(Task* task) {
+            const auto bottom = _bottom.load(std::memory_order_relaxed);
+            const auto top = _top.load(std::memory_order_acquire);
+            if (bottom - top >= Capacity) {
+                return false;
+            }
+            _tasks[bottom & (Capacity - 1)].store(task, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            _bottom.store(bottom + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Owner only. Newest first.
+        Task* pop() {
+            const auto bottom = _bottom.load(std::memory_order_relaxed) - 1;
+            _bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto top = _top.load(std::memory_order_relaxed);
+            if (top > bottom) {
+                _bottom.store(bottom + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            auto task = _tasks[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+            if (top == bottom) {
+                // Last task, race the thieves for it.
+                if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    task = nullptr;
+                }
+                _bottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+            return task;
+        }
+
+        // Any thread. Oldest first.
+        Task* steal() {
+            auto top = _top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const auto bottom = _bottom.load(std::memory_order_acquire);
+            if (top >= bottom) {
+                return nullptr;
+            }
+            const auto task = _tasks[top & (Capacity - 1)].load(std::memory_order_relaxed);
+            if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return task;
+        }
+
+    private:
+        alignas(64) std::atomic<int64_t> _top = 0;
+        alignas(64) std::atomic<int64_t> _bottom = 0;
+        std::array<std::atomic<Task*>, Capacity> _tasks{};
+    };
+
+    // Identifies the pool worker running on the current thread, if any.
+    struct Worker {
+        const void* jobs = nullptr;
+        unsigned index = 0;
+    };
+    inline thread_local Worker worker;
+}
+
+class JobSystem;
+
+// Refers to a submitted task. done() turns true once it has run; pass the
+// handle to JobSystem::wait or JobSystem::then to wait for it or to chain
+// work after it. Empty handles count as done.
+class Handle {
+public:
+    Handle() = default;
+
+    Handle(const Handle& other) : _task(other._task) {
+        if (_task) {
+            _task->retain();
+        }
+    }
+
+    Handle(Handle&& other) : _task(std::exchange(other._task, nullptr)) {}
+
+    Handle& operator=(Handle other) {
+        std::swap(_task, other._task);
+        return *this;
+    }
+
+    ~Handle() {
+        if (_task) {
+            _task->release();
+        }
+    }
+
+    bool done() const {
+        return !_task || _task->done.load(std::memory_order_acquire);
+    }
+
+private:
+    friend class JobSystem;
+
+    explicit Handle(detail::Task* task) : _task(task) {
+        _task->retain();
+    }
+
+    detail::Task* _task = nullptr;
+};
+
+class JobSystem {
+public:
+    // threads counts the threads that run tasks, including the ones that
+    // wait: a pool of n starts n - 1 workers, and a pool of 1 runs tasks
+    // only while something waits on it.
+    explicit JobSystem(unsigned threads = std::thread::hardware_concurrency())
+    : _threads(std::max(threads, 1u)),
+      _deques(_threads - 1) {
+        _workers.reserve(_threads - 1);
+        for (unsigned i = 0; i + 1 < _threads; ++i) {
+            _workers.emplace_back([this, i] { work(i); });
+        }
+    }
+
+    // Runs whatever is still queued before returning.
+    ~JobSystem() {
+        {
+            std::lock_guard lock(_sleepLock);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+        while (auto task = find()) {
+            execute(task);
+        }
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Pool shared by the engine and scenes, sized to the machine.
+    static JobSystem& shared() {
+        static JobSystem jobs;
+        return jobs;
+    }
+
+    unsigned threads() const {
+        return _threads;
+    }
+
+    template <class F>
+    Handle run(F&& f) {
+        auto task = new detail::Task{std::forward<F>(f)};
+        Handle handle(task);
+        schedule(task);
+        return handle;
+    }
+
+    // Runs f once every task in after has run.
+    template <class F>
+    Handle then(std::span<const Handle> after, F&& f) {
+        auto task = new detail::Task{std::forward<F>(f)};
+        Handle handle(task);
+        // Held until every dependency is registered, so that the ones
+        // finishing meanwhile cannot schedule the task early.
+        task->dependencies.store(uint32_t(after.size()) + 1, std::memory_order_relaxed);
+        for (const auto& dependency : after) {
+            task->retain();
+            if (!dependency._task || !enqueue(dependency._task, task)) {
+                resolve(task);
+            }
+        }
+        resolve(task);
+        return handle;
+    }
+
+    template <class F>
+    Handle then(std::initializer_list<Handle> after, F&& f) {
+        return then(std::span<const Handle>(after.begin(), after.size()), std::forward<F>(f));
+    }
+
+    template <class F>
+    Handle then(const Handle& after, F&& f) {
+        return then(std::span<const Handle>(&after, 1), std::forward<F>(f));
+    }
+
+    // Runs queued tasks on the calling thread until handle is done.
+    void wait(const Handle& handle) {
+        assist([&] { return handle.done(); });
+    }
+
+    // Calls f(begin, end) on consecutive subranges of [begin, end), at most
+    // grain long, in parallel, and returns when all have run. The calling
+    // thread takes part.
+    template <class F>
+    void parallelFor(size_t begin, size_t end, size_t grain, F&& f) {
+        if (begin >= end) {
+            return;
+        }
+        grain = std::max<size_t>(grain, 1);
+        const size_t chunks = (end - begin - 1) / grain + 1;
+        const size_t helpers = std::min<size_t>(chunks, _threads) - 1;
+
+        // Helpers claim chunks until none are left. One that starts late
+        // finds nothing to do, but must still have run before the stack
+        // frame they share goes away.
+        std::atomic<size_t> next = 0;
+        std::atomic<size_t> running = helpers;
+        auto body = [&] {
+            for (size_t chunk; (chunk = next.fetch_add(1, std::memory_order_relaxed)) < chunks; ) {
+                const size_t first = begin + chunk * grain;
+                f(first, std::min(end, first + grain));
+            }
+        };
+        for (size_t i = 0; i < helpers; ++i) {
+            auto task = new detail::Task{[&] {
+                body();
+                running.fetch_sub(1, std::memory_order_release);
+            }};
+            schedule(task);
+        }
+        body();
+        assist([&] { return running.load(std::memory_order_acquire) == 0; });
+    }
+
+    // Splits the range into a few chunks per thread.
+    template <class F>
+    void parallelFor(size_t begin, size_t end, F&& f) {
+        const size_t count = end > begin ? end - begin : 0;
+        parallelFor(begin, end, count / (4 * size_t(_threads)), std::forward<F>(f));
+    }
+
+private:
+    // Worker's deque when called from one of this pool's workers.
+    detail::TaskDeque* local() {
+        return detail::worker.jobs == this ? &_deques[detail::worker.index] : nullptr;
+    }
+
+    // Takes ownership of the queue's reference to task.
+    void schedule(detail::Task* task) {
+        if (auto deque = local()) {
+            if (!deque->push(task)) {
+                execute(task);
+                return;
+            }
+        } else {
+            std::lock_guard lock(_sharedLock);
+            _shared.push_back(task);
+        }
+        _queued.fetch_add(1, std::memory_order_seq_cst);
+        if (_sleeping.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard lock(_sleepLock);
+            _wake.notify_one();
+        }
+    }
+
+    // Adds continuation to task's list, handing it a reference, or returns
+    // false if task has already run.
+    bool enqueue(detail::Task* task, detail::Task* continuation) {
+        std::lock_guard lock(task->lock);
+        if (task->done.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        task->continuations.push_back(continuation);
+        return true;
+    }
+
+    void resolve(detail::Task* task) {
+        if (task->dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            schedule(task);
+        } else {
+            task->release();
+        }
+    }
+
+    void execute(detail::Task* task) {
+        task->work();
+        task->work = nullptr;
+
+        std::vector<detail::Task*> continuations;
+        {
+            std::lock_guard lock(task->lock);
+            task->done.store(true, std::memory_order_release);
+            continuations.swap(task->continuations);
+        }
+        for (auto continuation : continuations) {
+            resolve(continuation);
+        }
+        task->release();
+    }
+
+    detail::Task* find() {
+        const auto deque = local();
+        if (deque) {
+            if (auto task = deque->pop()) {
+                return taken(task);
+            }
+        }
+        if (_queued.load(std::memory_order_relaxed) == 0) {
+            return nullptr;
+        }
+        {
+            std::lock_guard lock(_sharedLock);
+            if (!_shared.empty()) {
+                auto task = _shared.front();
+                _shared.pop_front();
+                return taken(task);
+            }
+        }
+        // Start with a different victim each time so thieves spread out.
+        const size_t count = _deques.size();
+        const size_t first = _victim.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i) {
+            auto& victim = _deques[(first + i) % count];
+            if (&victim == deque) {
+                continue;
+            }
+            if (auto task = victim.steal()) {
+                return taken(task);
+            }
+        }
+        return nullptr;
+    }
+
+    detail::Task* taken(detail::Task* task) {
+        _queued.fetch_sub(1, std::memory_order_relaxed);
+        return task;
+    }
+
+    template <class Done>
+    void assist(Done&& done) {
+        while (!done()) {
+            if (auto task = find()) {
+                execute(task);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void work(unsigned index) {
+        detail::worker = detail::Worker{this, index};
+        for (;;) {
+            if (auto task = find()) {
+                execute(task);
+                continue;
+            }
+            std::unique_lock lock(_sleepLock);
+            if (_stopping && _queued.load(std::memory_order_seq_cst) == 0) {
+                return;
+            }
+            _sleeping.fetch_add(1, std::memory_order_seq_cst);
+            _wake.wait(lock, [this] {
+                return _stopping || _queued.load(std::memory_order_seq_cst) > 0;
+            });
+            _sleeping.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    const unsigned _threads;
+    std::vector<detail::TaskDeque> _deques;
+    std::vector<std::thread> _workers;
+
+    std::mutex _sharedLock;
+    std::deque<detail::Task*> _shared;
+
+    // Tasks in deques or the shared queue. Sleeping workers wake when it is
+    // nonzero; a push reads _sleeping after raising it and a worker checks
+    // it after raising _sleeping, so one of them sees the other.
+    std::atomic<int64_t> _queued = 0;
+    std::atomic<uint32_t> _sleeping = 0;
+    std::atomic<size_t> _victim = 0;
+    std::mutex _sleepLock;
+    std::condition_variable _wake;
+    bool _stopping = false;
+};
+
+} /* namespace Engine */
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <Metal/Metal.hpp>
+#include <cassert>
+#include <cstdint>
+#include <span>
+
+#include "../Utility/AppKitExt.hh"
+#include "./Engine.hh"
+#include "./CommandList.hh"
+#include "./MetalUpload.hh"
+
+namespace Engine {
+
+static_assert((NS::UInteger)PrimitiveType::Point == MTL::PrimitiveTypePoint);
+static_assert((NS::UInteger)PrimitiveType::Line == MTL::PrimitiveTypeLine);
+static_assert((NS::UInteger)PrimitiveType::LineStrip == MTL::PrimitiveTypeLineStrip);
+static_assert((NS::UInteger)PrimitiveType::Triangle == MTL::PrimitiveTypeTriangle);
+static_assert((NS::UInteger)PrimitiveType::TriangleStrip == MTL::PrimitiveTypeTriangleStrip);
+
+// Returns a retained pipeline state, reporting failures the way the renderers do.
+INLINE
+MTL::RenderPipelineState* makePipeline(MTL::Device* device,
+                                       MTL::Library* library,
+                                       const char* vertexFunction,
+                                       const char* fragmentFunction,
+                                       MTL::PixelFormat pixelFormat
+                                       ) {
+    NS::Error* err = nullptr;
+    auto vertexShader = NSExt::ns_ptr(library->newFunction(NSExt::UTF8String(vertexFunction)));
+    auto fragmentShader = NSExt::ns_ptr(library->newFunction(NSExt::UTF8String(fragmentFunction)));
+    auto desc = NSExt::ns_ptr(MTL::RenderPipelineDescriptor::alloc()->init());
+
+    desc->setVertexFunction(vertexShader.get());
+    desc->setFragmentFunction(fragmentShader.get());
+    desc->colorAttachments()->object(0)->setPixelFormat(pixelFormat);
+
+    auto state = device->newRenderPipelineState(desc.get(), &err);
+    if ( !state )
+    {
+        __builtin_printf( "%s", err->localizedDescription()->utf8String() );
+        assert( false );
+    }
+    return state;
+}
+
+// Encodes a recorded command list. Data goes through setVertexBytes while it
+// is under its 4 KiB limit and through uploads beyond that. Pipeline states
+// are only switched when the pipeline id changes.
+//
+// Data over the limit that finds no room in the ring, or no ring, cannot be
+// bound, and a draw that needs it is skipped rather than drawn with what
+// the slot held before. Returns the number of draws skipped.
+INLINE
+uint32_t replay(MTL::RenderCommandEncoder* enc,
+                const CommandList& list,
+                std::span<MTL::RenderPipelineState* const> pipelines,
+                const Bindings& bindings,
+                MetalUploadRing* uploads = nullptr
+                ) {
+    constexpr size_t maxBytes = 4096;
+    int bound = -1;
+    uint32_t skipped = 0;
+    // Slots whose latest Bytes command could not be bound.
+    uint32_t unbound = 0;
+
+    auto bind = [&](std::span<const std::byte> data, uint8_t slot) {
+        if (data.size() <= maxBytes) {
+            enc->setVertexBytes(data.data(), data.size(), slot);
+            return true;
+        }
+        const auto upload = uploads ? uploads->upload(data.data(), data.size()) : UploadRing::Allocation{};
+        if (!upload) {
+            return false;
+        }
+        enc->setVertexBuffer(uploads->buffer(), upload.offset, slot);
+        return true;
+    };
+
+    for (const auto& command : list.commands()) {
+        const auto data = list.view(command.data);
+
+        if (command.type == Command::Type::Bytes) {
+            const uint32_t bit = 1u << (command.slot % 32);
+            unbound = bind(data, command.slot) ? unbound & ~bit : unbound | bit;
+            continue;
+        }
+
+        if (command.pipeline != bound) {
+            bound = command.pipeline;
+            enc->setRenderPipelineState(pipelines[bound]);
+        }
+        const bool ready = !unbound &&
+            (data.empty() || bind(data, bindings.vertices)) &&
+            (!command.instanceCount || bind(list.view(command.instances), bindings.instances));
+        if (!ready) {
+            skipped++;
+            continue;
+        }
+
+        const auto primitive = (MTL::PrimitiveType)command.primitive;
+        if (command.instanceCount) {
+            enc->drawPrimitives(primitive, NS::UInteger(0), NS::UInteger(command.vertexCount), NS::UInteger(command.instanceCount));
+        } else {
+            enc->setVertexBytes(&command.color, sizeof(command.color), bindings.color);
+            enc->drawPrimitives(primitive, NS::UInteger(0), NS::UInteger(command.vertexCount));
+        }
+    }
+    return skipped;
+}
+
+} /* namespace Engine */
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Metal/Metal.hpp>
+#include <cstring>
+#include <memory>
+#include <span>
+
+#include "../Utility/AppKitExt.hh"
+#include "./UploadRing.hh"
+
+namespace Engine {
+
+// UploadRing over a managed MTL::Buffer, fenced by the completed handlers of
+// the command buffers it is committed with.
+//
+//     auto instances = uploads.allocate(size);
+//     ... fill instances.data ...
+//     enc->setVertexBuffer(uploads.buffer(), instances.offset, index);
+//     ...
+//     uploads.commit(cmdBuffer);
+//     cmdBuffer->commit();
+//
+// The ring may go away with command buffers still in flight: their handlers
+// share ownership of the completion they signal, and the command buffers
+// keep the MTL::Buffer alive.
+class MetalUploadRing {
+public:
+    MetalUploadRing(MTL::Device* device, size_t capacity)
+    : _buffer(device->newBuffer(capacity, MTL::ResourceStorageModeManaged)),
+      _completion(std::make_shared<SignaledCompletion>()),
+      _ring(std::span<std::byte>(static_cast<std::byte*>(_buffer->contents()), capacity), *_completion) {}
+
+    MTL::Buffer* buffer() const {
+        return _buffer.get();
+    }
+
+    UploadRing::Allocation allocate(size_t size, size_t alignment = 256) {
+        return _ring.allocate(size, alignment);
+    }
+
+    UploadRing::Allocation upload(const void* data, size_t size, size_t alignment = 256) {
+        const auto allocation = _ring.allocate(size, alignment);
+        if (allocation) {
+            std::memcpy(allocation.data, data, size);
+        }
+        return allocation;
+    }
+
+    // Flushes this frame's writes and recycles its space once the command
+    // buffer completes. Call before committing cmdBuffer.
+    void commit(MTL::CommandBuffer* cmdBuffer) {
+        for (const auto& range : _ring.frameRanges()) {
+            _buffer->didModifyRange(NS::Range::Make(range.offset, range.size));
+        }
+        const auto frame = _ring.endFrame();
+        auto completion = _completion;
+        cmdBuffer->addCompletedHandler(^void(MTL::CommandBuffer*) {
+            completion->signal(frame);
+        });
+    }
+
+    const UploadRing::Stats& stats() const {
+        return _ring.stats();
+    }
+
+private:
+    NSExt::ns_ptr<MTL::Buffer> _buffer;
+    std::shared_ptr<SignaledCompletion> _completion;
+    UploadRing _ring;
+};
+
+} /* namespace Engine */
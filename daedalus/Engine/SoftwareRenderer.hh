@@ -0,0 +1,392 @@
+#pragma once
+
+#include <simd/simd.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "./CommandList.hh"
+#include "./Jobs.hh"
+#include "./Trace.hh"
+
+// CPU backend replaying a CommandList into a BGRA8 sRGB image, for rendering
+// scenes where there is no GPU. Scenes provide C++ counterparts of their
+// Metal vertex shaders, indexed by pipeline id like the Metal states.
+namespace Engine {
+namespace Software {
+
+struct VertexOut {
+    simd::float4 position;
+    simd::float4 color;
+};
+
+// Data bound to the vertex buffer slots, as the shaders see it.
+class Buffers {
+public:
+    static constexpr size_t Slots = 31;
+
+    template <class T, class Slot>
+    const T* get(Slot slot) const {
+        return reinterpret_cast<const T*>(_slots[(size_t)slot].data());
+    }
+
+    void bind(size_t slot, std::span<const std::byte> data) {
+        _slots[slot] = data;
+    }
+
+private:
+    std::array<std::span<const std::byte>, Slots> _slots{};
+};
+
+using VertexShader = VertexOut (*)(const Buffers& buffers, uint32_t vertexId, uint32_t instanceId);
+
+// What a scene's Metal renderer sets up, for the rasterizer: shaders in
+// pipeline id order, buffer slots and the clear color.
+struct Program {
+    std::span<const VertexShader> pipelines;
+    Bindings bindings;
+    simd::float4 clearColor;
+};
+
+// Pixels as MTL::PixelFormatBGRA8Unorm_sRGB stores them: one little-endian
+// word per pixel, B in the low byte, rows from the top. Rows are padded to
+// whole tiles so the rasterizer never handles partial blocks.
+struct Framebuffer {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t stride = 0;
+    std::vector<uint32_t> pixels;
+
+    void resize(uint32_t width, uint32_t height, uint32_t tileSize) {
+        this->width = width;
+        this->height = height;
+        stride = (width + tileSize - 1) / tileSize * tileSize;
+        pixels.resize(size_t(stride) * ((height + tileSize - 1) / tileSize * tileSize));
+    }
+
+    uint32_t* row(uint32_t y) {
+        return pixels.data() + size_t(y) * stride;
+    }
+
+    const uint32_t* row(uint32_t y) const {
+        return pixels.data() + size_t(y) * stride;
+    }
+};
+
+// Encodes a linear color the way an sRGB render target does on store.
+inline uint32_t packSRGB(const simd::float4& color) {
+    auto encode = [](float c) {
+        c = std::clamp(c, 0.0f, 1.0f);
+        c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1 / 2.4f) - 0.055f;
+        return uint32_t(c * 255 + 0.5f);
+    };
+    const uint32_t a = uint32_t(std::clamp(color.w, 0.0f, 1.0f) * 255 + 0.5f);
+    return a << 24 | encode(color.x) << 16 | encode(color.y) << 8 | encode(color.z);
+}
+
+// Tile-based rasterizer. render() runs the vertex shaders and assembles
+// triangles on the calling thread, bins them into square tiles, then
+// rasterizes the tiles in parallel, each in submission order. Pixels are
+// sampled at their centers with the top-left fill rule after snapping
+// vertices to 1/256 pixel, four pixels per step.
+//
+// Beyond what the scenes need there is no clipping (triangles with a vertex
+// at w <= 0 are dropped), blending or depth. Lines are 1 pixel wide quads,
+// points 1 pixel squares. Every shader in the repo gives a draw or instance a
+// single color, so triangles are filled with their first vertex's color.
+class Rasterizer {
+public:
+    static constexpr uint32_t TileSize = 64;
+    static constexpr float SubpixelSteps = 256;
+
+    struct Stats {
+        uint32_t vertices;
+        uint32_t triangles;
+        // Triangle-tile pairs, and tiles with any triangle.
+        uint32_t binned;
+        uint32_t tiles;
+    };
+
+    explicit Rasterizer(JobSystem& jobs = JobSystem::shared())
+    : _jobs(jobs) {}
+
+    const Stats& stats() const {
+        return _stats;
+    }
+
+    // Replays the list into framebuffer, which is resized to width x height
+    // and cleared to the program's clear color first.
+    void render(Framebuffer& framebuffer,
+                uint32_t width,
+                uint32_t height,
+                const CommandList& list,
+                const Program& program
+                ) {
+        framebuffer.resize(width, height, TileSize);
+        std::fill(framebuffer.pixels.begin(), framebuffer.pixels.end(), packSRGB(program.clearColor));
+
+        _stats = {};
+        _triangles.clear();
+        _width = width;
+        _height = height;
+        _columns = framebuffer.stride / TileSize;
+        _rows = (height + TileSize - 1) / TileSize;
+        _bins.resize(size_t(_columns) * _rows);
+        for (auto& bin : _bins) {
+            bin.clear();
+        }
+
+        assemble(list, program.pipelines, program.bindings);
+        bin();
+
+        _jobs.parallelFor(0, _bins.size(), 1, [&](size_t begin, size_t end) {
+            TRACE_ZONE("Rasterizer::rasterize");
+            for (size_t tile = begin; tile < end; ++tile) {
+                rasterize(framebuffer, uint32_t(tile));
+            }
+        });
+    }
+
+private:
+    struct Triangle {
+        simd::float2 v[3];
+        uint32_t color;
+        int32_t minX, minY, maxX, maxY;
+    };
+
+    // Shades every vertex of the list's draws and turns their primitives
+    // into pixel space triangles.
+    void assemble(const CommandList& list,
+                  std::span<const VertexShader> pipelines,
+                  const Bindings& bindings
+                  ) {
+        TRACE_ZONE("Rasterizer::assemble");
+        Buffers buffers;
+        const simd::float2 size{float(_width), float(_height)};
+        // Colors repeat for whole draws, encode each only once.
+        simd::float4 lastColor{NAN, NAN, NAN, NAN};
+        uint32_t lastPacked = 0;
+
+        for (const auto& command : list.commands()) {
+            if (command.type == Command::Type::Bytes) {
+                buffers.bind(command.slot, list.view(command.data));
+                continue;
+            }
+            buffers.bind(bindings.vertices, list.view(command.data));
+            buffers.bind(bindings.color, std::as_bytes(std::span(&command.color, 1)));
+            buffers.bind(bindings.instances, list.view(command.instances));
+
+            const auto shader = pipelines[command.pipeline];
+            for (uint32_t instance = 0; instance < std::max(command.instanceCount, 1u); ++instance) {
+                _positions.clear();
+                _colors.clear();
+                for (uint32_t vertex = 0; vertex < command.vertexCount; ++vertex) {
+                    const auto out = shader(buffers, vertex, instance);
+                    _positions.push_back(toPixels(out.position, size));
+                    if (!(out.color.x == lastColor.x && out.color.y == lastColor.y &&
+                          out.color.z == lastColor.z && out.color.w == lastColor.w)) {
+                        lastColor = out.color;
+                        lastPacked = packSRGB(out.color);
+                    }
+                    _colors.push_back(lastPacked);
+                }
+                _stats.vertices += command.vertexCount;
+                primitives(command.primitive);
+            }
+        }
+    }
+
+    // Viewport transform of a clip space position, y pointing down. NaN
+    // marks positions behind the eye.
+    static simd::float2 toPixels(const simd::float4& clip, const simd::float2& size) {
+        if (!(clip.w > 0)) {
+            return simd::float2{NAN, NAN};
+        }
+        const simd::float2 ndc{clip.x / clip.w, clip.y / clip.w};
+        const simd::float2 pixels{(ndc.x + 1) * 0.5f * size.x, (1 - ndc.y) * 0.5f * size.y};
+        return simd::float2{
+            std::round(pixels.x * SubpixelSteps) / SubpixelSteps,
+            std::round(pixels.y * SubpixelSteps) / SubpixelSteps,
+        };
+    }
+
+    void primitives(PrimitiveType primitive) {
+        const auto n = _positions.size();
+        switch (primitive) {
+            case PrimitiveType::Triangle:
+                for (size_t i = 0; i + 2 < n; i += 3) {
+                    triangle(i, i + 1, i + 2, _colors[i]);
+                }
+                break;
+            case PrimitiveType::TriangleStrip:
+                for (size_t i = 0; i + 2 < n; ++i) {
+                    triangle(i, i + 1, i + 2, _colors[i]);
+                }
+                break;
+            case PrimitiveType::Line:
+                for (size_t i = 0; i + 1 < n; i += 2) {
+                    line(_positions[i], _positions[i + 1], _colors[i]);
+                }
+                break;
+            case PrimitiveType::LineStrip:
+                for (size_t i = 0; i + 1 < n; ++i) {
+                    line(_positions[i], _positions[i + 1], _colors[i]);
+                }
+                break;
+            case PrimitiveType::Point:
+                for (size_t i = 0; i < n; ++i) {
+                    const auto p = _positions[i];
+                    const simd::float2 h{0.5f, 0.5f};
+                    triangle(p - h, simd::float2{p.x + h.x, p.y - h.y}, simd::float2{p.x - h.x, p.y + h.y}, _colors[i]);
+                    triangle(simd::float2{p.x + h.x, p.y - h.y}, p + h, simd::float2{p.x - h.x, p.y + h.y}, _colors[i]);
+                }
+                break;
+        }
+    }
+
+    void triangle(size_t a, size_t b, size_t c, uint32_t color) {
+        triangle(_positions[a], _positions[b], _positions[c], color);
+    }
+
+    void line(const simd::float2& a, const simd::float2& b, uint32_t color) {
+        const auto d = b - a;
+        const float length = simd::length(d);
+        if (!(length > 0)) {
+            return;
+        }
+        const simd::float2 n{-d.y / length * 0.5f, d.x / length * 0.5f};
+        triangle(a - n, a + n, b + n, color);
+        triangle(a - n, b + n, b - n, color);
+    }
+
+    // Orients the triangle counter-clockwise on screen, drops degenerate
+    // ones and computes the range of pixel centers it may cover.
+    void triangle(simd::float2 a, simd::float2 b, simd::float2 c, uint32_t color) {
+        const float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if (!std::isfinite(area) || area == 0) {
+            return;
+        }
+        if (area < 0) {
+            std::swap(b, c);
+        }
+        const auto lo = simd::min(simd::min(a, b), c);
+        const auto hi = simd::max(simd::max(a, b), c);
+        const float limit = 1 << 24;
+        if (lo.x < -limit || lo.y < -limit || hi.x > limit || hi.y > limit) {
+            return;
+        }
+        Triangle t{
+            {a, b, c}, color,
+            std::max(int32_t(std::ceil(lo.x - 0.5f)), 0),
+            std::max(int32_t(std::ceil(lo.y - 0.5f)), 0),
+            std::min(int32_t(std::floor(hi.x - 0.5f)), int32_t(_width) - 1),
+            std::min(int32_t(std::floor(hi.y - 0.5f)), int32_t(_height) - 1),
+        };
+        if (t.minX > t.maxX || t.minY > t.maxY) {
+            return;
+        }
+        _triangles.push_back(t);
+        _stats.triangles++;
+    }
+
+    void bin() {
+        TRACE_ZONE("Rasterizer::bin");
+        for (uint32_t i = 0; i < _triangles.size(); ++i) {
+            const auto& t = _triangles[i];
+            for (int32_t row = t.minY / TileSize; row <= t.maxY / int32_t(TileSize); ++row) {
+                for (int32_t column = t.minX / TileSize; column <= t.maxX / int32_t(TileSize); ++column) {
+                    auto& bin = _bins[row * _columns + column];
+                    _stats.tiles += bin.empty();
+                    bin.push_back(i);
+                    _stats.binned++;
+                }
+            }
+        }
+    }
+
+    typedef float Floats __attribute__((vector_size(16)));
+    typedef int32_t Mask __attribute__((vector_size(16)));
+    typedef uint32_t Pixels __attribute__((vector_size(16)));
+
+    // Edge function A x + B y + C, positive inside, of the edge a -> b.
+    // Pixels exactly on it belong to the triangle if it is a top or left
+    // edge.
+    struct Edge {
+        float a, b, c;
+        Mask topLeft;
+
+        Edge(const simd::float2& from, const simd::float2& to) {
+            const float dx = to.x - from.x, dy = to.y - from.y;
+            a = -dy;
+            b = dx;
+            c = dy * from.x - dx * from.y;
+            const bool isTopLeft = dy < 0 || (dy == 0 && dx > 0);
+            topLeft = Mask{} + (isTopLeft ? -1 : 0);
+        }
+
+        Mask inside(const Floats& e) const {
+            return (e > 0) | ((e == 0) & topLeft);
+        }
+    };
+
+    void rasterize(Framebuffer& framebuffer, uint32_t tile) {
+        const auto& bin = _bins[tile];
+        if (bin.empty()) {
+            return;
+        }
+        const int32_t tileX = int32_t(tile % _columns * TileSize);
+        const int32_t tileY = int32_t(tile / _columns * TileSize);
+        const Floats lanes{0.5f, 1.5f, 2.5f, 3.5f};
+
+        for (const auto index : bin) {
+            const auto& t = _triangles[index];
+            const Edge edges[3] = {{t.v[0], t.v[1]}, {t.v[1], t.v[2]}, {t.v[2], t.v[0]}};
+
+            // Blocks of four start at multiples of four, which the tile and
+            // row padding keep inside the framebuffer.
+            const int32_t x0 = std::max(t.minX, tileX) & ~3;
+            const int32_t x1 = std::min(t.maxX, tileX + int32_t(TileSize) - 1);
+            const int32_t y0 = std::max(t.minY, tileY);
+            const int32_t y1 = std::min(t.maxY, tileY + int32_t(TileSize) - 1);
+            const Pixels color = Pixels{} + t.color;
+
+            for (int32_t y = y0; y <= y1; ++y) {
+                const float yc = float(y) + 0.5f;
+                Floats e[3];
+                for (int i = 0; i < 3; ++i) {
+                    e[i] = edges[i].a * (lanes + float(x0)) + (edges[i].b * yc + edges[i].c);
+                }
+                uint32_t* row = framebuffer.row(y);
+                for (int32_t x = x0; x <= x1; x += 4) {
+                    const Mask mask = edges[0].inside(e[0]) & edges[1].inside(e[1]) & edges[2].inside(e[2]);
+                    Pixels pixels;
+                    std::memcpy(&pixels, row + x, sizeof(pixels));
+                    pixels = (pixels & ~Pixels(mask)) | (color & Pixels(mask));
+                    std::memcpy(row + x, &pixels, sizeof(pixels));
+                    for (int i = 0; i < 3; ++i) {
+                        e[i] += edges[i].a * 4;
+                    }
+                }
+            }
+        }
+    }
+
+    JobSystem& _jobs;
+    uint32_t _width = 0;
+    uint32_t _height = 0;
+    uint32_t _columns = 0;
+    uint32_t _rows = 0;
+    Stats _stats{};
+    std::vector<simd::float2> _positions;
+    std::vector<uint32_t> _colors;
+    std::vector<Triangle> _triangles;
+    std::vector<std::vector<uint32_t>> _bins;
+};
+
+} /* namespace Software */
+} /* namespace Engine */
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// Scoped timing zones written to per-thread buffers and exported as Chrome
+// trace JSON, which chrome://tracing and ui.perfetto.dev open.
+//
+//     void Scene::onIdle(const Engine::FrameContext& frame) {
+//         TRACE_ZONE("S13E01::onIdle");
+//         ...
+//
+// While tracing is off a zone costs a relaxed load and a branch when it
+// opens, and a test of the register it set when it closes.
+namespace Engine {
+namespace Trace {
+
+// Complete event of a zone, times in steady_clock nanoseconds.
+struct Event {
+    const char* name;
+    int64_t begin;
+    int64_t end;
+};
+
+// Events of one thread. Only the owner writes; count is published with
+// release so that exporting from another thread reads whole events.
+// Buffers are linked into a lock-free list on first use and live as long as
+// the process, so exports still see threads that have exited.
+struct Buffer {
+    static constexpr uint32_t Capacity = 1 << 16;
+
+    Event events[Capacity];
+    std::atomic<uint32_t> count = 0;
+    std::atomic<uint32_t> dropped = 0;
+    uint32_t thread = 0;
+    const char* name = nullptr;
+    Buffer* next = nullptr;
+};
+
+namespace detail {
+    inline std::atomic<bool> enabled = false;
+    inline std::atomic<int64_t> origin = 0;
+    inline std::atomic<Buffer*> buffers = nullptr;
+    inline std::atomic<uint32_t> threads = 0;
+    inline thread_local Buffer* local = nullptr;
+    inline thread_local const char* localName = nullptr;
+
+    inline Buffer* buffer() {
+        if (!local) [[unlikely]] {
+            auto buffer = new Buffer;
+            buffer->thread = threads.fetch_add(1, std::memory_order_relaxed) + 1;
+            buffer->name = localName;
+            buffer->next = buffers.load(std::memory_order_relaxed);
+            while (!buffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release, std::memory_order_relaxed)) {}
+            local = buffer;
+        }
+        return local;
+    }
+}
+
+inline int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline bool enabled() {
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+// Names the calling thread in exports. name must outlive the process.
+inline void setThreadName(const char* name) {
+    detail::localName = name;
+    if (detail::local) {
+        detail::local->name = name;
+    }
+}
+
+// Forgets earlier events and starts recording. Zones open across the call
+// may leave one stale event in their thread's buffer.
+inline void start() {
+    for (auto buffer = detail::buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+    }
+    detail::origin.store(now(), std::memory_order_relaxed);
+    detail::enabled.store(true, std::memory_order_release);
+}
+
+inline void stop() {
+    detail::enabled.store(false, std::memory_order_release);
+}
+
+inline void record(const char* name, int64_t begin, int64_t end) {
+    auto buffer = detail::buffer();
+    const auto n = buffer->count.load(std::memory_order_relaxed);
+    if (n == Buffer::Capacity) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events[n] = Event{name, begin, end};
+    buffer->count.store(n + 1, std::memory_order_release);
+}
+
+class Zone {
+public:
+    explicit Zone(const char* name) {
+        if (enabled()) [[unlikely]] {
+            _name = name;
+            _begin = now();
+        }
+    }
+
+    ~Zone() {
+        if (_name) [[unlikely]] {
+            record(_name, _begin, now());
+        }
+    }
+
+    Zone(const Zone&) = delete;
+    Zone& operator=(const Zone&) = delete;
+
+private:
+    const char* _name = nullptr;
+    int64_t _begin = 0;
+};
+
+// Writes every thread's events as a Chrome trace JSON object, timestamps in
+// microseconds since start(). Zone names are written as given, so they
+// should not need escaping.
+inline bool write(FILE* file) {
+    const auto origin = detail::origin.load(std::memory_order_relaxed);
+    const char* separator = "";
+    uint64_t dropped = 0;
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (auto buffer = detail::buffers.load(std::memory_order_acquire); buffer; buffer = buffer->next) {
+        if (buffer->name) {
+            std::fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                         separator, buffer->thread, buffer->name);
+            separator = ",";
+        }
+        const auto count = buffer->count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < count; ++i) {
+            const auto& event = buffer->events[i];
+            std::fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         separator, event.name, buffer->thread,
+                         double(event.begin - origin) / 1e3, double(event.end - event.begin) / 1e3);
+            separator = ",";
+        }
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    std::fprintf(file, "\n],\"otherData\":{\"dropped\":%llu}}\n", (unsigned long long)dropped);
+    return !std::ferror(file);
+}
+
+inline bool write(const char* path) {
+    FILE* file = std::fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    const bool ok = write(file);
+    return std::fclose(file) == 0 && ok;
+}
+
+} /* namespace Trace */
+} /* namespace Engine */
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_ZONE(name) ::Engine::Trace::Zone TRACE_CONCAT(traceZone, __LINE__)(name)
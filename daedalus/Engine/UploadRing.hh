@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace Engine {
+
+// Tells whoever reuses memory the GPU reads which submitted frames it has
+// finished with. Frames are numbered from 1 in submission order and complete
+// in that order.
+struct CompletionSource {
+    virtual ~CompletionSource() = default;
+
+    // Number of the last frame that has completed, 0 if none has.
+    virtual uint64_t completed() const = 0;
+
+    // Returns once completed() >= frame.
+    virtual void wait(uint64_t frame) = 0;
+};
+
+// Completion signaled from whatever learns about it, e.g. a command
+// buffer's completed handler on another thread.
+class SignaledCompletion : public CompletionSource {
+public:
+    void signal(uint64_t frame) {
+        auto completed = _completed.load(std::memory_order_relaxed);
+        while (completed < frame && !_completed.compare_exchange_weak(completed, frame, std::memory_order_release, std::memory_order_relaxed)) {}
+        _completed.notify_all();
+    }
+
+    uint64_t completed() const override {
+        return _completed.load(std::memory_order_acquire);
+    }
+
+    void wait(uint64_t frame) override {
+        for (auto completed = this->completed(); completed < frame; completed = this->completed()) {
+            _completed.wait(completed, std::memory_order_acquire);
+        }
+    }
+
+private:
+    std::atomic<uint64_t> _completed = 0;
+};
+
+// Sub-allocates per-frame data out of one persistent buffer, for data the
+// GPU reads after the frame is recorded: instance records, uniforms, long
+// vertex streams. Allocations are carved in order and never straddle the
+// end of the buffer. Once a frame is submitted its space is recycled as
+// soon as the completion source reports it done. An allocation that does
+// not fit waits for the oldest frame in flight, and fails only when the
+// frame being recorded fills the ring alone.
+//
+// Offsets are counted from the start of the buffer, as setVertexBuffer
+// wants them.
+class UploadRing {
+public:
+    struct Allocation {
+        std::byte* data;
+        size_t offset;
+        size_t size;
+
+        explicit operator bool() const {
+            return data != nullptr;
+        }
+    };
+
+    // Byte range of the buffer, for flushing writes to managed memory.
+    struct Range {
+        size_t offset;
+        size_t size;
+    };
+
+    struct Stats {
+        // Bytes held by the frame being recorded and the frames in flight,
+        // and the most ever held at once.
+        size_t used;
+        size_t highWater;
+        // Allocations that had to wait for the GPU, and ones that failed.
+        uint32_t waits;
+        uint32_t failed;
+    };
+
+    // More frames than this in flight make allocate() wait as if the ring
+    // were full.
+    static constexpr size_t MaxFramesInFlight = 16;
+
+    UploadRing(std::span<std::byte> memory, CompletionSource& completion)
+    : _memory(memory),
+      _completion(completion) {}
+
+    // Space for size bytes at an offset that is a multiple of alignment, a
+    // power of two. The memory is uninitialized.
+    Allocation allocate(size_t size, size_t alignment = 256) {
+        assert((alignment & (alignment - 1)) == 0);
+        if (size == 0 || size > capacity()) {
+            _stats.failed += size != 0;
+            return Allocation{};
+        }
+
+        retire();
+        uint64_t begin = place(size, alignment);
+        bool waited = false;
+        while (begin + size - _tail > capacity()) {
+            if (_inFlight == 0) {
+                _stats.failed++;
+                return Allocation{};
+            }
+            _completion.wait(_frames[_oldest].frame);
+            waited = true;
+            retire();
+            begin = place(size, alignment);
+        }
+        _stats.waits += waited;
+
+        _head = begin + size;
+        _stats.used = _head - _tail;
+        _stats.highWater = std::max(_stats.highWater, _stats.used);
+        const size_t offset = begin % capacity();
+        return Allocation{_memory.data() + offset, offset, size};
+    }
+
+    // The ranges written since the previous endFrame(), at most two when
+    // the frame wrapped around. Includes padding.
+    std::span<const Range> frameRanges() {
+        const size_t capacity = _memory.size();
+        const size_t size = _head - _frameBegin;
+        if (size == 0) {
+            return {};
+        }
+        const size_t offset = _frameBegin % capacity;
+        if (offset + size <= capacity) {
+            _ranges[0] = Range{offset, size};
+            return {_ranges.data(), 1};
+        }
+        _ranges[0] = Range{offset, capacity - offset};
+        _ranges[1] = Range{0, offset + size - capacity};
+        return {_ranges.data(), 2};
+    }
+
+    // Closes the frame being recorded. Returns its number, which the
+    // completion source must report once the GPU is done with the frame.
+    uint64_t endFrame() {
+        if (_inFlight == MaxFramesInFlight) {
+            _completion.wait(_frames[_oldest].frame);
+            retire();
+        }
+        const auto frame = ++_submitted;
+        _frames[(_oldest + _inFlight) % MaxFramesInFlight] = Frame{frame, _head};
+        _inFlight++;
+        _frameBegin = _head;
+        return frame;
+    }
+
+    size_t capacity() const {
+        return _memory.size();
+    }
+
+    const Stats& stats() const {
+        return _stats;
+    }
+
+private:
+    struct Frame {
+        uint64_t frame;
+        // Where the frame's allocations end.
+        uint64_t end;
+    };
+
+    // Where an allocation would start: aligned after the head, or at the
+    // start of the buffer if it would not fit before the end. An empty ring
+    // restarts there, so that anything up to the capacity fits.
+    uint64_t place(size_t size, size_t alignment) {
+        const size_t capacity = this->capacity();
+        const size_t offset = _head % capacity;
+        const size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+        const uint64_t begin = aligned + size <= capacity ? _head + (aligned - offset) : _head - offset + capacity;
+        if (_tail == _head) {
+            _tail = _frameBegin = begin;
+        }
+        return begin;
+    }
+
+    // Frees the frames the GPU has finished with.
+    void retire() {
+        const auto completed = _completion.completed();
+        while (_inFlight && _frames[_oldest].frame <= completed) {
+            _tail = std::max(_tail, _frames[_oldest].end);
+            _oldest = (_oldest + 1) % MaxFramesInFlight;
+            _inFlight--;
+        }
+        _stats.used = _head - _tail;
+    }
+
+    std::span<std::byte> _memory;
+    CompletionSource& _completion;
+    // Offsets counted without wrapping: the ring holds [_tail, _head),
+    // the frame being recorded [_frameBegin, _head).
+    uint64_t _head = 0;
+    uint64_t _tail = 0;
+    uint64_t _frameBegin = 0;
+    uint64_t _submitted = 0;
+    std::array<Frame, MaxFramesInFlight> _frames{};
+    size_t _oldest = 0;
+    size_t _inFlight = 0;
+    std::array<Range, 2> _ranges{};
+    Stats _stats{};
+};
+
+} /* namespace Engine */
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+
+#include "./Harness.hh"
+#include "./Image.hh"
+
+namespace Headless {
+
+struct Tolerance {
+    // Largest difference of a channel still counted as equal.
+    uint8_t channel = 2;
+    // Number of pixels allowed to differ by more.
+    uint64_t pixels = 0;
+};
+
+struct GoldenResult {
+    enum class Status { Match, Mismatch, Recorded, Missing };
+
+    Status status;
+    Diff diff;
+};
+
+// A frame of a scripted run to compare with <name>.ppm.
+struct GoldenFrame {
+    const char* name;
+    uint64_t frame;
+};
+
+// Compares image with directory/<name>.ppm. On a mismatch the image and the
+// heatmap are written to output as <name>.actual.ppm and <name>.diff.ppm. A
+// missing golden is recorded from image when record is set.
+inline GoldenResult checkGolden(const std::filesystem::path& directory,
+                                const std::filesystem::path& output,
+                                const std::string& name,
+                                const Image& image,
+                                const Tolerance& tolerance,
+                                bool record = false
+                                ) {
+    const auto golden = directory / (name + ".ppm");
+    Image expected;
+    if (!readPPM(golden.c_str(), expected)) {
+        if (record && writePPM(golden.c_str(), image)) {
+            return GoldenResult{GoldenResult::Status::Recorded, {}};
+        }
+        return GoldenResult{GoldenResult::Status::Missing, {}};
+    }
+
+    Image heatmap;
+    const auto diff = compare(expected, image, tolerance.channel, &heatmap);
+    if (!diff.sizeMismatch && diff.pixels <= tolerance.pixels) {
+        return GoldenResult{GoldenResult::Status::Match, diff};
+    }
+    std::filesystem::create_directories(output);
+    writePPM((output / (name + ".actual.ppm")).c_str(), image);
+    if (!diff.sizeMismatch) {
+        writePPM((output / (name + ".diff.ppm")).c_str(), heatmap);
+    }
+    return GoldenResult{GoldenResult::Status::Mismatch, diff};
+}
+
+// Advances the harness through frames, sorted by frame, checking each and
+// handing every result to report(frame, result). Returns the number of
+// frames that were missing or did not match.
+template <class Report>
+size_t checkGoldens(Harness& harness,
+                    std::span<const GoldenFrame> frames,
+                    const std::filesystem::path& directory,
+                    const std::filesystem::path& output,
+                    const Tolerance& tolerance,
+                    Report&& report,
+                    bool record = false
+                    ) {
+    size_t failures = 0;
+    for (const auto& frame : frames) {
+        harness.advanceTo(frame.frame);
+        const auto result = checkGolden(directory, output, frame.name, Image::capture(harness.render()), tolerance, record);
+        if (result.status == GoldenResult::Status::Missing || result.status == GoldenResult::Status::Mismatch) {
+            failures++;
+        }
+        report(frame, result);
+    }
+    return failures;
+}
+
+} /* namespace Headless */
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <simd/simd.h>
+#include <cassert>
+#include <cstdint>
+#include <span>
+
+#include "../Engine/Engine.hh"
+#include "../Engine/Clock.hh"
+#include "../Engine/CommandList.hh"
+#include "../Engine/SoftwareRenderer.hh"
+
+namespace Headless {
+
+// Input the harness hands to the scene at the start of a frame, before its
+// onIdle. Clicks and keys use state, mouse events position.
+struct InputEvent {
+    enum class Type { MouseClick, MouseMove, Key };
+
+    uint64_t frame;
+    Type type;
+    simd::float2 position{};
+    Engine::Input::MouseButton button = Engine::Input::MouseButton::Left;
+    Engine::Input::KeyboardButton key{};
+    Engine::Input::ButtonState state = Engine::Input::ButtonState::Down;
+};
+
+// Hands event to the scene's input callback.
+inline void dispatch(Engine::Scene& scene, const InputEvent& event) {
+    switch (event.type) {
+        case InputEvent::Type::MouseClick:
+            scene.onMouseClicked(event.button, event.state, event.position);
+            break;
+        case InputEvent::Type::MouseMove:
+            scene.onMouseMoved(event.position);
+            break;
+        case InputEvent::Type::Key:
+            scene.onKey(event.key, event.state);
+            break;
+    }
+}
+
+// Drives a scene without a window on a virtual clock: frame n happens at
+// startTime + n * frameTime whatever the wall clock says, input comes from a
+// script sorted by frame and frames are drawn with the software rasterizer.
+class Harness {
+public:
+    Harness(Engine::Scene& scene,
+            const Engine::Software::Program& program,
+            uint32_t width,
+            uint32_t height,
+            std::span<const InputEvent> script = {},
+            Engine::Ticks frameTime = Engine::ticks(1.0 / 60),
+            Engine::Ticks startTime = 0,
+            Engine::JobSystem& jobs = Engine::JobSystem::shared()
+            )
+    : _scene(scene),
+      _program(program),
+      _width(width),
+      _height(height),
+      _script(script),
+      _frameTime(frameTime),
+      _clock(startTime),
+      _rasterizer(jobs) {
+        _scene.onInit(_timer.start(_clock.now()));
+        dispatch();
+    }
+
+    uint64_t frame() const {
+        return _frame;
+    }
+
+    const Engine::FrameContext& context() const {
+        return _timer.current();
+    }
+
+    void advance(uint64_t frames = 1) {
+        advanceTo(_frame + frames);
+    }
+
+    void advanceTo(uint64_t frame) {
+        assert(frame >= _frame);
+        while (_frame < frame) {
+            _frame++;
+            _clock.advance(_frameTime);
+            dispatch();
+            _scene.onIdle(_timer.tick(_clock.now()));
+        }
+    }
+
+    // Draws the current frame. The result stays valid until the next call.
+    const Engine::Software::Framebuffer& render() {
+        _commands.reset();
+        _scene.onDraw(_commands);
+        _rasterizer.render(_framebuffer, _width, _height, _commands, _program);
+        return _framebuffer;
+    }
+
+    const Engine::CommandList& commands() const {
+        return _commands;
+    }
+
+    const Engine::Software::Rasterizer& rasterizer() const {
+        return _rasterizer;
+    }
+
+private:
+    void dispatch() {
+        for (; _next < _script.size() && _script[_next].frame <= _frame; ++_next) {
+            assert(_script[_next].frame == _frame && "input script must be sorted by frame");
+            Headless::dispatch(_scene, _script[_next]);
+        }
+    }
+
+    Engine::Scene& _scene;
+    const Engine::Software::Program& _program;
+    uint32_t _width;
+    uint32_t _height;
+    std::span<const InputEvent> _script;
+    size_t _next = 0;
+    uint64_t _frame = 0;
+    Engine::Ticks _frameTime;
+    Engine::VirtualClock _clock;
+    Engine::FrameTimer _timer;
+    Engine::CommandList _commands;
+    Engine::Software::Rasterizer _rasterizer;
+    Engine::Software::Framebuffer _framebuffer;
+};
+
+} /* namespace Headless */
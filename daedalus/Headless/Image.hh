@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "../Engine/SoftwareRenderer.hh"
+
+namespace Headless {
+
+// Tightly packed pixels in the framebuffer's BGRA8 words, rows from the top.
+struct Image {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint32_t> pixels;
+
+    static Image capture(const Engine::Software::Framebuffer& framebuffer) {
+        Image image{framebuffer.width, framebuffer.height, {}};
+        image.pixels.resize(size_t(image.width) * image.height);
+        for (uint32_t y = 0; y < image.height; ++y) {
+            std::memcpy(image.pixels.data() + size_t(y) * image.width, framebuffer.row(y), image.width * sizeof(uint32_t));
+        }
+        return image;
+    }
+};
+
+// Binary PPM, the simplest format every image viewer opens. Alpha is not
+// stored: the view presents opaque, and the shaders leave it at 0 anyway.
+inline bool writePPM(const char* path, const Image& image) {
+    FILE* file = std::fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    std::fprintf(file, "P6\n%u %u\n255\n", image.width, image.height);
+    std::vector<uint8_t> row(size_t(image.width) * 3);
+    for (uint32_t y = 0; y < image.height; ++y) {
+        for (uint32_t x = 0; x < image.width; ++x) {
+            const uint32_t p = image.pixels[size_t(y) * image.width + x];
+            row[3 * x] = uint8_t(p >> 16);
+            row[3 * x + 1] = uint8_t(p >> 8);
+            row[3 * x + 2] = uint8_t(p);
+        }
+        std::fwrite(row.data(), 1, row.size(), file);
+    }
+    return std::fclose(file) == 0;
+}
+
+// Reads what writePPM writes, alpha set to 255.
+inline bool readPPM(const char* path, Image& image) {
+    FILE* file = std::fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    unsigned width, height, max;
+    const bool header = std::fscanf(file, "P6 %u %u %u", &width, &height, &max) == 3 && max == 255 && std::fgetc(file) != EOF;
+    if (!header) {
+        std::fclose(file);
+        return false;
+    }
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(size_t(width) * height);
+    std::vector<uint8_t> row(size_t(width) * 3);
+    bool ok = true;
+    for (uint32_t y = 0; y < height && ok; ++y) {
+        ok = std::fread(row.data(), 1, row.size(), file) == row.size();
+        for (uint32_t x = 0; x < width; ++x) {
+            image.pixels[size_t(y) * width + x] = 0xffu << 24 | uint32_t(row[3 * x]) << 16 | uint32_t(row[3 * x + 1]) << 8 | row[3 * x + 2];
+        }
+    }
+    std::fclose(file);
+    return ok;
+}
+
+struct Diff {
+    bool sizeMismatch;
+    // Pixels whose largest channel difference is over the tolerance.
+    uint64_t pixels;
+    uint32_t maxDelta;
+};
+
+namespace detail {
+    typedef uint32_t Words __attribute__((vector_size(16)));
+    typedef int32_t Mask __attribute__((vector_size(16)));
+
+    inline Words select(Mask mask, Words a, Words b) {
+        return (a & Words(mask)) | (b & ~Words(mask));
+    }
+
+    // Largest of the R, G and B differences of four pixels at once.
+    inline Words delta(Words a, Words b) {
+        Words result{};
+        for (int shift = 0; shift < 24; shift += 8) {
+            const Words ca = (a >> shift) & 0xff, cb = (b >> shift) & 0xff;
+            const Words d = select(ca > cb, ca - cb, cb - ca);
+            result = select(d > result, d, result);
+        }
+        return result;
+    }
+
+    // Unchanged pixels are the expected image dimmed to gray, differences
+    // within the tolerance dark yellow, and the rest red, brighter the
+    // larger the difference.
+    inline uint32_t heat(uint32_t expected, uint32_t delta, uint32_t tolerance) {
+        if (delta == 0) {
+            const uint32_t gray = ((expected >> 16 & 0xff) + (expected >> 8 & 0xff) + (expected & 0xff)) / 9;
+            return 0xffu << 24 | gray << 16 | gray << 8 | gray;
+        }
+        if (delta <= tolerance) {
+            return 0xff808000;
+        }
+        return 0xffu << 24 | (128 + delta / 2) << 16;
+    }
+}
+
+// Compares RGB per pixel, four pixels per step. heatmap, if given, is
+// filled with a picture of where and how much the images differ.
+inline Diff compare(const Image& expected, const Image& actual, uint8_t tolerance, Image* heatmap = nullptr) {
+    if (expected.width != actual.width || expected.height != actual.height) {
+        return Diff{true, uint64_t(actual.width) * actual.height, 255};
+    }
+    const size_t n = expected.pixels.size();
+    if (heatmap) {
+        *heatmap = Image{expected.width, expected.height, std::vector<uint32_t>(n)};
+    }
+
+    using namespace detail;
+    const Words limit = Words{} + tolerance;
+    Words count{}, largest{};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        Words a, b;
+        std::memcpy(&a, expected.pixels.data() + i, sizeof(a));
+        std::memcpy(&b, actual.pixels.data() + i, sizeof(b));
+        const Words d = delta(a, b);
+        count -= Words(d > limit);
+        largest = select(d > largest, d, largest);
+        if (heatmap) {
+            for (int lane = 0; lane < 4; ++lane) {
+                heatmap->pixels[i + lane] = heat(a[lane], d[lane], tolerance);
+            }
+        }
+    }
+
+    Diff diff{false, uint64_t(count[0]) + count[1] + count[2] + count[3], std::max({largest[0], largest[1], largest[2], largest[3]})};
+    for (; i < n; ++i) {
+        const uint32_t d = delta(Words{} + expected.pixels[i], Words{} + actual.pixels[i])[0];
+        diff.pixels += d > tolerance;
+        diff.maxDelta = std::max(diff.maxDelta, d);
+        if (heatmap) {
+            heatmap->pixels[i] = heat(expected.pixels[i], d, tolerance);
+        }
+    }
+    return diff;
+}
+
+} /* namespace Headless */
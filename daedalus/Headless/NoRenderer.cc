@@ -0,0 +1,21 @@
+#include "../Scenes/S13E01/Scene.hh"
+#include "../Scenes/S13E02/Scene.hh"
+#include "../Scenes/NavigateCube/Scene.hh"
+
+// Takes the place of the scenes' Metal Renderer.cc files in headless builds,
+// where there is no view to render to.
+namespace Scenes {
+
+Engine::Renderer* S13E01::Scene::createRenderer(MTK::View*) {
+    return nullptr;
+}
+
+Engine::Renderer* S13E02::Scene::createRenderer(MTK::View*) {
+    return nullptr;
+}
+
+Engine::Renderer* NavigateCube::Scene::createRenderer(MTK::View*) {
+    return nullptr;
+}
+
+} /* namespace Scenes */
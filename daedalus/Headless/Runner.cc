@@ -0,0 +1,360 @@
+// Command-line runner for benchmarking scenes without a window.
+//
+//     daedalus-run S13E01 --frames 3600 --synthetic 1 --output s13e01.json
+//
+// Runs a registered scene on a virtual clock, frame n at n * frame time,
+// feeding it a recorded or synthetic input script. Every frame goes through
+// the phases the app runs (input callbacks, onIdle, onDraw) and the software
+// rasterizer, each timed separately, and the run is reported as JSON:
+// nanoseconds per frame with percentiles, and heap allocations per frame.
+//
+// It needs no Apple frameworks. On Linux, from the repository root:
+//
+//     c++ -std=c++20 -O2 -pthread -I daedalus/Portable -o daedalus-run
+//         daedalus/Headless/Runner.cc daedalus/Headless/NoRenderer.cc
+//         daedalus/Scenes/*/Scene.cc
+
+#include <simd/simd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <optional>
+#include <vector>
+
+#include "../Engine/Engine.hh"
+#include "../Engine/Clock.hh"
+#include "../Engine/CommandList.hh"
+#include "../Engine/Jobs.hh"
+#include "../Engine/SoftwareRenderer.hh"
+#include "../Scenes/Registry.hh"
+#include "./Harness.hh"
+#include "./Script.hh"
+
+// Every heap allocation of the process is counted, including those of the
+// job system's workers.
+namespace {
+    std::atomic<uint64_t> allocations = 0;
+    std::atomic<uint64_t> allocatedBytes = 0;
+
+    void* allocate(size_t size, size_t alignment = 0) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        size = std::max<size_t>(size, 1);
+        void* p = alignment > alignof(std::max_align_t)
+            ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+            : std::malloc(size);
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+}
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return allocate(size, size_t(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocate(size, size_t(alignment)); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace Headless {
+
+enum Phase { Input, Idle, Draw, Raster, Frame, PhaseCount };
+constexpr const char* phaseNames[PhaseCount] = {"input", "idle", "draw", "raster", "frame"};
+
+// Measurements of one phase, one entry per measured frame.
+struct Samples {
+    std::vector<int64_t> nanoseconds;
+    std::vector<uint64_t> allocations;
+    uint64_t bytes = 0;
+};
+
+// Times a phase and counts what it allocates.
+class Probe {
+public:
+    explicit Probe(Samples& samples)
+    : _samples(samples),
+      _allocations(allocations.load(std::memory_order_relaxed)),
+      _bytes(allocatedBytes.load(std::memory_order_relaxed)),
+      _begin(std::chrono::steady_clock::now()) {}
+
+    ~Probe() {
+        const auto end = std::chrono::steady_clock::now();
+        _samples.nanoseconds.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - _begin).count());
+        _samples.allocations.push_back(allocations.load(std::memory_order_relaxed) - _allocations);
+        _samples.bytes += allocatedBytes.load(std::memory_order_relaxed) - _bytes;
+    }
+
+private:
+    Samples& _samples;
+    uint64_t _allocations;
+    uint64_t _bytes;
+    std::chrono::steady_clock::time_point _begin;
+};
+
+struct Options {
+    const char* scene = nullptr;
+    uint64_t frames = 600;
+    uint64_t warmup = 60;
+    double frameTime = 1.0 / 60;
+    uint32_t width = 600;
+    uint32_t height = 600;
+    unsigned threads = 0;
+    bool render = true;
+    const char* script = nullptr;
+    std::optional<uint32_t> seed;
+    const char* recordScript = nullptr;
+    const char* output = nullptr;
+};
+
+void usage() {
+    std::fprintf(stderr,
+        "usage: daedalus-run <scene> [options]\n"
+        "       daedalus-run --list\n"
+        "  --frames N          measured frames (600)\n"
+        "  --warmup N          frames run before measuring (60)\n"
+        "  --frame-time S      virtual seconds per frame (1/60)\n"
+        "  --size W H          viewport in pixels (600 600)\n"
+        "  --threads N         rasterizer threads, 0 for all cores (0)\n"
+        "  --no-render         skip the software rasterizer\n"
+        "  --script PATH       input script to play\n"
+        "  --synthetic SEED    play generated mouse drags instead\n"
+        "  --record-script P   write the input played to P\n"
+        "  --output PATH       write the report to PATH instead of stdout\n");
+}
+
+bool parse(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        auto next = [&] { return i + 1 < argc ? argv[++i] : nullptr; };
+        auto number = [&](auto& value) {
+            const char* text = next();
+            if (!text) {
+                return false;
+            }
+            char* end;
+            const double parsed = std::strtod(text, &end);
+            value = decltype(+value)(parsed);
+            return *end == '\0' && parsed >= 0;
+        };
+        bool ok = true;
+        if (!std::strcmp(arg, "--frames")) {
+            ok = number(options.frames) && options.frames > 0;
+        } else if (!std::strcmp(arg, "--warmup")) {
+            ok = number(options.warmup);
+        } else if (!std::strcmp(arg, "--frame-time")) {
+            ok = number(options.frameTime) && options.frameTime > 0;
+        } else if (!std::strcmp(arg, "--size")) {
+            ok = number(options.width) && number(options.height) && options.width > 0 && options.height > 0;
+        } else if (!std::strcmp(arg, "--threads")) {
+            ok = number(options.threads);
+        } else if (!std::strcmp(arg, "--no-render")) {
+            options.render = false;
+        } else if (!std::strcmp(arg, "--script")) {
+            ok = (options.script = next()) != nullptr;
+        } else if (!std::strcmp(arg, "--synthetic")) {
+            uint32_t seed = 0;
+            ok = number(seed);
+            options.seed = seed;
+        } else if (!std::strcmp(arg, "--record-script")) {
+            ok = (options.recordScript = next()) != nullptr;
+        } else if (!std::strcmp(arg, "--output")) {
+            ok = (options.output = next()) != nullptr;
+        } else if (arg[0] != '-' && !options.scene) {
+            options.scene = arg;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::fprintf(stderr, "bad argument: %s\n", arg);
+            return false;
+        }
+    }
+    if (options.script && options.seed) {
+        std::fprintf(stderr, "--script and --synthetic cannot be combined\n");
+        return false;
+    }
+    return options.scene != nullptr;
+}
+
+// Nearest-rank percentile of sorted values.
+int64_t percentile(const std::vector<int64_t>& sorted, double p) {
+    const size_t rank = std::max<size_t>(1, size_t(std::ceil(p / 100 * sorted.size())));
+    return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+void report(FILE* file, const Options& options, unsigned threads, size_t events, const Samples (&samples)[PhaseCount],
+            const std::vector<uint32_t>& commands, size_t arenaHighWater) {
+    std::fprintf(file, "{\n");
+    std::fprintf(file, "  \"scene\": \"%s\",\n", options.scene);
+    std::fprintf(file, "  \"frames\": %llu,\n", (unsigned long long)options.frames);
+    std::fprintf(file, "  \"warmup\": %llu,\n", (unsigned long long)options.warmup);
+    std::fprintf(file, "  \"frameTime\": %.9g,\n", options.frameTime);
+    std::fprintf(file, "  \"width\": %u,\n", options.width);
+    std::fprintf(file, "  \"height\": %u,\n", options.height);
+    std::fprintf(file, "  \"threads\": %u,\n", threads);
+    std::fprintf(file, "  \"render\": %s,\n", options.render ? "true" : "false");
+    std::fprintf(file, "  \"events\": %zu,\n", events);
+
+    std::fprintf(file, "  \"phases\": {");
+    const char* separator = "\n";
+    for (int phase = 0; phase < PhaseCount; ++phase) {
+        const auto& s = samples[phase];
+        if (s.nanoseconds.empty()) {
+            continue;
+        }
+        auto sorted = s.nanoseconds;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0;
+        for (auto ns : sorted) {
+            total += double(ns);
+        }
+        uint64_t allocated = 0, most = 0;
+        for (auto count : s.allocations) {
+            allocated += count;
+            most = std::max(most, count);
+        }
+        const double n = double(sorted.size());
+        std::fprintf(file, "%s    \"%s\": {\"meanNs\": %.1f, \"minNs\": %lld, \"p50Ns\": %lld, \"p90Ns\": %lld, \"p99Ns\": %lld, \"maxNs\": %lld, "
+                     "\"allocationsPerFrame\": %.3f, \"maxAllocations\": %llu, \"allocatedBytesPerFrame\": %.1f}",
+                     separator, phaseNames[phase], total / n,
+                     (long long)sorted.front(), (long long)percentile(sorted, 50), (long long)percentile(sorted, 90),
+                     (long long)percentile(sorted, 99), (long long)sorted.back(),
+                     double(allocated) / n, (unsigned long long)most, double(s.bytes) / n);
+        separator = ",\n";
+    }
+    std::fprintf(file, "\n  },\n");
+
+    uint64_t total = 0;
+    uint32_t most = 0;
+    for (auto count : commands) {
+        total += count;
+        most = std::max(most, count);
+    }
+    std::fprintf(file, "  \"commands\": {\"mean\": %.1f, \"max\": %u, \"arenaHighWaterBytes\": %zu}\n",
+                 commands.empty() ? 0.0 : double(total) / commands.size(), most, arenaHighWater);
+    std::fprintf(file, "}\n");
+}
+
+int run(int argc, char** argv) {
+    if (argc == 2 && !std::strcmp(argv[1], "--list")) {
+        for (const auto& registration : Scenes::registry) {
+            std::printf("%s%s\n", registration.name, registration.program ? "" : " (no software shaders)");
+        }
+        return 0;
+    }
+    Options options;
+    if (!parse(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    const auto registration = Scenes::find(options.scene);
+    if (!registration) {
+        std::fprintf(stderr, "no scene named %s, see --list\n", options.scene);
+        return 2;
+    }
+
+    const uint64_t frames = options.warmup + options.frames;
+    std::vector<InputEvent> script;
+    if (options.script && !readScript(options.script, script)) {
+        std::fprintf(stderr, "cannot read script %s\n", options.script);
+        return 1;
+    }
+    if (options.seed) {
+        script = syntheticScript(frames, simd::float2{(float)options.width, (float)options.height}, *options.seed);
+    }
+    if (options.recordScript && !writeScript(options.recordScript, script)) {
+        std::fprintf(stderr, "cannot write script %s\n", options.recordScript);
+        return 1;
+    }
+
+    // Scenes without software shaders still record their draws; there is
+    // just nothing to rasterize them with.
+    const auto program = registration->program ? registration->program() : nullptr;
+    const bool render = options.render && program;
+    Engine::JobSystem jobs(options.threads ? options.threads : std::thread::hardware_concurrency());
+    Engine::Software::Rasterizer rasterizer(jobs);
+    Engine::Software::Framebuffer framebuffer;
+    Engine::CommandList commands;
+
+    // Frame times are in whole ticks, so frame n is at exactly n times the
+    // rounded frame time however long the run.
+    const auto frameTicks = Engine::ticks(options.frameTime);
+    Engine::VirtualClock clock;
+    Engine::FrameTimer timer;
+
+    auto scene = registration->make();
+    scene->onInit(timer.start(clock.now()));
+
+    Samples samples[PhaseCount];
+    Samples discarded[PhaseCount];
+    std::vector<uint32_t> commandCounts;
+    commandCounts.reserve(options.frames);
+    for (auto& s : samples) {
+        s.nanoseconds.reserve(options.frames);
+        s.allocations.reserve(options.frames);
+    }
+    for (auto& s : discarded) {
+        s.nanoseconds.reserve(options.warmup);
+        s.allocations.reserve(options.warmup);
+    }
+
+    size_t next = 0;
+    for (uint64_t frame = 1; frame <= frames; ++frame) {
+        const bool measured = frame > options.warmup;
+        auto& s = measured ? samples : discarded;
+        Probe whole(s[Frame]);
+        {
+            Probe probe(s[Input]);
+            for (; next < script.size() && script[next].frame <= frame; ++next) {
+                dispatch(*scene, script[next]);
+            }
+        }
+        {
+            Probe probe(s[Idle]);
+            clock.advance(frameTicks);
+            scene->onIdle(timer.tick(clock.now()));
+        }
+        {
+            Probe probe(s[Draw]);
+            commands.reset();
+            scene->onDraw(commands);
+        }
+        if (render) {
+            Probe probe(s[Raster]);
+            rasterizer.render(framebuffer, options.width, options.height, commands, *program);
+        }
+        if (measured) {
+            commandCounts.push_back(commands.stats().commands);
+        }
+    }
+
+    FILE* file = options.output ? std::fopen(options.output, "w") : stdout;
+    if (!file) {
+        std::fprintf(stderr, "cannot write %s\n", options.output);
+        return 1;
+    }
+    auto reported = options;
+    reported.render = render;
+    report(file, reported, jobs.threads(), script.size(), samples, commandCounts, commands.arena().stats().highWater);
+    return (file == stdout ? std::fflush(file) : std::fclose(file)) == 0 ? 0 : 1;
+}
+
+} /* namespace Headless */
+
+int main(int argc, char** argv) {
+    return Headless::run(argc, argv);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <simd/simd.h>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "./Harness.hh"
+
+// Input scripts as text, one event per line, sorted by frame:
+//
+//     # frame event arguments
+//     10 click 120 80 left down
+//     11 move 140 90
+//     14 click 140 90 left up
+//     30 key 49 down
+//
+// Positions are in pixels from the lower left corner, keys are macOS key
+// codes as in Engine::Input::KeyboardButton.
+namespace Headless {
+
+inline bool readScript(const char* path, std::vector<InputEvent>& script) {
+    FILE* file = std::fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    script.clear();
+    char line[256];
+    unsigned number = 0;
+    bool ok = true;
+    while (ok && std::fgets(line, sizeof(line), file)) {
+        number++;
+        unsigned long long frame;
+        char type[16], button[16], state[16];
+        float x, y;
+        unsigned key;
+        const char* text = line;
+        while (std::isspace((unsigned char)*text)) {
+            text++;
+        }
+        if (*text == '\0' || *text == '#') {
+            continue;
+        }
+        InputEvent event{};
+        if (std::sscanf(line, "%llu %15s", &frame, type) != 2) {
+            ok = false;
+        } else if (!std::strcmp(type, "click") && std::sscanf(line, "%*u %*s %f %f %15s %15s", &x, &y, button, state) == 4) {
+            event = InputEvent{frame, InputEvent::Type::MouseClick, {x, y}};
+            event.button = std::strcmp(button, "right") ? Engine::Input::MouseButton::Left : Engine::Input::MouseButton::Right;
+            event.state = std::strcmp(state, "up") ? Engine::Input::ButtonState::Down : Engine::Input::ButtonState::Up;
+        } else if (!std::strcmp(type, "move") && std::sscanf(line, "%*u %*s %f %f", &x, &y) == 2) {
+            event = InputEvent{frame, InputEvent::Type::MouseMove, {x, y}};
+        } else if (!std::strcmp(type, "key") && std::sscanf(line, "%*u %*s %u %15s", &key, state) == 2) {
+            event = InputEvent{frame, InputEvent::Type::Key};
+            event.key = (Engine::Input::KeyboardButton)key;
+            event.state = std::strcmp(state, "up") ? Engine::Input::ButtonState::Down : Engine::Input::ButtonState::Up;
+        } else {
+            ok = false;
+        }
+        if (ok && !script.empty() && frame < script.back().frame) {
+            ok = false;
+        }
+        if (!ok) {
+            std::fprintf(stderr, "%s:%u: malformed or out of order event\n", path, number);
+            break;
+        }
+        script.push_back(event);
+    }
+    std::fclose(file);
+    return ok;
+}
+
+inline bool writeScript(const char* path, const std::vector<InputEvent>& script) {
+    FILE* file = std::fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    for (const auto& event : script) {
+        const char* state = event.state == Engine::Input::ButtonState::Up ? "up" : "down";
+        switch (event.type) {
+            case InputEvent::Type::MouseClick:
+                std::fprintf(file, "%llu click %g %g %s %s\n", (unsigned long long)event.frame, event.position.x, event.position.y,
+                             event.button == Engine::Input::MouseButton::Right ? "right" : "left", state);
+                break;
+            case InputEvent::Type::MouseMove:
+                std::fprintf(file, "%llu move %g %g\n", (unsigned long long)event.frame, event.position.x, event.position.y);
+                break;
+            case InputEvent::Type::Key:
+                std::fprintf(file, "%llu key %u %s\n", (unsigned long long)event.frame, (unsigned)event.key, state);
+                break;
+        }
+    }
+    return std::fclose(file) == 0;
+}
+
+// Left-button drags over the viewport, the same for the same seed: every
+// period frames the button goes down somewhere, the mouse moves once a
+// frame for a while and the button comes up where it stopped.
+inline std::vector<InputEvent> syntheticScript(uint64_t frames, simd::float2 viewport, uint32_t seed, uint64_t period = 120) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> unit(0, 1);
+    auto point = [&] { return simd::float2{unit(random) * viewport.x, unit(random) * viewport.y}; };
+
+    std::vector<InputEvent> script;
+    for (uint64_t start = period / 2; start + period / 2 < frames; start += period) {
+        auto position = point();
+        const auto target = point();
+        const uint64_t moves = period / 4;
+        script.push_back(InputEvent{start, InputEvent::Type::MouseClick, position});
+        for (uint64_t i = 1; i <= moves; ++i) {
+            position = position + (target - position) / float(moves - i + 1);
+            script.push_back(InputEvent{start + i, InputEvent::Type::MouseMove, position});
+        }
+        auto release = InputEvent{start + moves + 1, InputEvent::Type::MouseClick, position};
+        release.state = Engine::Input::ButtonState::Up;
+        script.push_back(release);
+    }
+    return script;
+}
+
+} /* namespace Headless */
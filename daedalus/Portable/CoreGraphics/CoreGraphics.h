@@ -0,0 +1,19 @@
+#pragma once
+
+// Stand-in for <CoreGraphics/CoreGraphics.h> with the few types the engine's
+// platform-independent headers name, so scenes build off-Apple next to
+// Portable/simd. On Apple platforms it forwards to the system header.
+
+#if defined(__APPLE__)
+#include_next <CoreGraphics/CoreGraphics.h>
+#else
+
+typedef double CFTimeInterval;
+typedef double CGFloat;
+
+struct CGSize {
+    CGFloat width;
+    CGFloat height;
+};
+
+#endif
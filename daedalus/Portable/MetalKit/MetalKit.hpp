@@ -0,0 +1,30 @@
+#pragma once
+
+// Stand-in for metal-cpp's <MetalKit/MetalKit.hpp> that declares just enough
+// for Engine/Engine.hh: the view a renderer is created for and the delegate
+// interface renderers implement. Nothing can render through it; off-Apple,
+// scenes are drawn by the software rasterizer and their createRenderer comes
+// from Headless/NoRenderer.cc. On Apple platforms it forwards to metal-cpp.
+
+#if defined(__APPLE__)
+#include_next <MetalKit/MetalKit.hpp>
+#else
+
+#include <CoreGraphics/CoreGraphics.h>
+
+#define _MTL_INLINE inline __attribute__((always_inline))
+
+namespace MTK {
+
+class View;
+
+class ViewDelegate {
+public:
+    virtual ~ViewDelegate() {}
+    virtual void drawInMTKView(View*) {}
+    virtual void drawableSizeWillChange(View*, CGSize) {}
+};
+
+} /* namespace MTK */
+
+#endif
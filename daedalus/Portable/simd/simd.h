@@ -0,0 +1,361 @@
+#pragma once
+
+// Drop-in stand-in for Apple's <simd/simd.h> so CPU-side code (Utility/Math.hh,
+// curve evaluation, scene physics) can be built and profiled off-Apple.
+// Add daedalus/Portable to the include path and keep including <simd/simd.h>.
+//
+// Only the subset of the Apple API used in this repo is provided. Vectors are
+// aggregates wrapping GCC/Clang vector extensions, so arithmetic compiles to
+// SSE/AVX/NEON. The memory layout matches Apple's: float3 is padded to 16 bytes,
+// float3x3 is three float3 columns, so ShaderTypes.hh structs stay compatible.
+// Lanes left out of a brace initializer, as in `simd::float4{1}`, are zero
+// without tripping -Wmissing-field-initializers.
+
+#if defined(__APPLE__)
+#include_next <simd/simd.h>
+#else
+
+#include <math.h>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace simd {
+namespace detail {
+
+template <class T, int N> struct native;
+
+#define SIMD_PORTABLE_NATIVE(T, N, LANES) \
+template <> struct native<T, N> { typedef T type __attribute__((vector_size(sizeof(T) * LANES))); };
+
+SIMD_PORTABLE_NATIVE(float, 2, 2)
+SIMD_PORTABLE_NATIVE(float, 3, 4)
+SIMD_PORTABLE_NATIVE(float, 4, 4)
+SIMD_PORTABLE_NATIVE(int32_t, 2, 2)
+SIMD_PORTABLE_NATIVE(int32_t, 3, 4)
+SIMD_PORTABLE_NATIVE(int32_t, 4, 4)
+SIMD_PORTABLE_NATIVE(uint32_t, 2, 2)
+SIMD_PORTABLE_NATIVE(uint32_t, 3, 4)
+SIMD_PORTABLE_NATIVE(uint32_t, 4, 4)
+
+#undef SIMD_PORTABLE_NATIVE
+
+template <class T, int N> struct vector;
+
+// Read/write view of the first three lanes of a 4-wide vector. Assigning
+// through it leaves the fourth lane untouched, like Apple's `.xyz = ...`.
+template <class T>
+struct swizzle3 {
+    T e[4];
+    constexpr operator vector<T, 3>() const { return {e[0], e[1], e[2]}; }
+    constexpr swizzle3& operator=(const vector<T, 3>& o) {
+        e[0] = o.x; e[1] = o.y; e[2] = o.z;
+        return *this;
+    }
+};
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+template <class T>
+struct vector<T, 2> {
+    using scalar_type = T;
+    static constexpr int count = 2;
+    union {
+        struct { T x = 0, y = 0; };
+        struct { T r, g; };
+        typename native<T, 2>::type v;
+    };
+    constexpr T operator[](int i) const { return i == 0 ? x : y; }
+    T& operator[](int i) { return (&x)[i]; }
+};
+
+template <class T>
+struct vector<T, 3> {
+    using scalar_type = T;
+    static constexpr int count = 3;
+    union {
+        struct { T x = 0, y = 0, z = 0; };
+        struct { T r, g, b; };
+        struct { vector<T, 2> xy; };
+        typename native<T, 3>::type v;
+    };
+    constexpr T operator[](int i) const { return i == 0 ? x : i == 1 ? y : z; }
+    T& operator[](int i) { return (&x)[i]; }
+};
+
+template <class T>
+struct vector<T, 4> {
+    using scalar_type = T;
+    static constexpr int count = 4;
+    union {
+        struct { T x = 0, y = 0, z = 0, w = 0; };
+        struct { T r, g, b, a; };
+        struct { vector<T, 2> xy, zw; };
+        swizzle3<T> xyz;
+        swizzle3<T> rgb;
+        typename native<T, 4>::type v;
+    };
+    constexpr T operator[](int i) const { return i == 0 ? x : i == 1 ? y : i == 2 ? z : w; }
+    T& operator[](int i) { return (&x)[i]; }
+};
+
+#pragma GCC diagnostic pop
+
+// Constant evaluation cannot look through the union into the native vector,
+// so every operator has a lane-by-lane fallback used only at compile time.
+template <class T, int N, class F, size_t... I>
+constexpr vector<T, N> lanewise(const vector<T, N>& a, const vector<T, N>& b, F f, std::index_sequence<I...>) {
+    return vector<T, N>{ f(a[I], b[I])... };
+}
+
+template <class T, int N, class F>
+constexpr vector<T, N> lanewise(const vector<T, N>& a, const vector<T, N>& b, F f) {
+    return lanewise(a, b, f, std::make_index_sequence<N>{});
+}
+
+template <class T, int N>
+constexpr vector<T, N> splat(T s) {
+    if constexpr (N == 2) {
+        return {s, s};
+    } else if constexpr (N == 3) {
+        return {s, s, s};
+    } else {
+        return {s, s, s, s};
+    }
+}
+
+#define SIMD_PORTABLE_BINARY_OP(OP) \
+template <class T, int N> \
+constexpr vector<T, N> operator OP(vector<T, N> a, vector<T, N> b) { \
+    if (std::is_constant_evaluated()) { \
+        return lanewise(a, b, [](T l, T r) { return l OP r; }); \
+    } \
+    vector<T, N> ret; \
+    ret.v = a.v OP b.v; \
+    return ret; \
+} \
+template <class T, int N, class S> requires std::is_arithmetic_v<S> \
+constexpr vector<T, N> operator OP(vector<T, N> a, S s) { \
+    return a OP splat<T, N>(T(s)); \
+} \
+template <class T, int N, class S> requires std::is_arithmetic_v<S> \
+constexpr vector<T, N> operator OP(S s, vector<T, N> a) { \
+    return splat<T, N>(T(s)) OP a; \
+} \
+template <class T, int N> \
+constexpr vector<T, N>& operator OP##=(vector<T, N>& a, vector<T, N> b) { \
+    return a = a OP b; \
+} \
+template <class T, int N, class S> requires std::is_arithmetic_v<S> \
+constexpr vector<T, N>& operator OP##=(vector<T, N>& a, S s) { \
+    return a = a OP splat<T, N>(T(s)); \
+}
+
+SIMD_PORTABLE_BINARY_OP(+)
+SIMD_PORTABLE_BINARY_OP(-)
+SIMD_PORTABLE_BINARY_OP(*)
+SIMD_PORTABLE_BINARY_OP(/)
+
+#undef SIMD_PORTABLE_BINARY_OP
+
+template <class T, int N>
+constexpr vector<T, N> operator-(vector<T, N> a) {
+    return splat<T, N>(T(0)) - a;
+}
+
+template <class T, int N>
+constexpr vector<T, N> operator+(vector<T, N> a) {
+    return a;
+}
+
+} /* namespace detail */
+} /* namespace simd */
+
+typedef simd::detail::vector<float, 2> simd_float2;
+typedef simd::detail::vector<float, 3> simd_float3;
+typedef simd::detail::vector<float, 4> simd_float4;
+typedef simd::detail::vector<int32_t, 2> simd_int2;
+typedef simd::detail::vector<int32_t, 3> simd_int3;
+typedef simd::detail::vector<int32_t, 4> simd_int4;
+typedef simd::detail::vector<uint32_t, 2> simd_uint2;
+typedef simd::detail::vector<uint32_t, 3> simd_uint3;
+typedef simd::detail::vector<uint32_t, 4> simd_uint4;
+
+typedef simd_float2 vector_float2;
+typedef simd_float3 vector_float3;
+typedef simd_float4 vector_float4;
+typedef simd_int2 vector_int2;
+typedef simd_int3 vector_int3;
+typedef simd_int4 vector_int4;
+typedef simd_uint2 vector_uint2;
+typedef simd_uint3 vector_uint3;
+typedef simd_uint4 vector_uint4;
+
+typedef struct { simd_float3 columns[3]; } simd_float3x3;
+typedef struct { simd_float4 columns[4]; } simd_float4x4;
+
+typedef simd_float3x3 matrix_float3x3;
+typedef simd_float4x4 matrix_float4x4;
+
+static_assert(sizeof(simd_float2) == 8 && alignof(simd_float2) == 8);
+static_assert(sizeof(simd_float3) == 16 && alignof(simd_float3) == 16);
+static_assert(sizeof(simd_float4) == 16 && alignof(simd_float4) == 16);
+static_assert(sizeof(simd_float3x3) == 48 && sizeof(simd_float4x4) == 64);
+
+namespace simd {
+
+typedef ::simd_float2 float2;
+typedef ::simd_float3 float3;
+typedef ::simd_float4 float4;
+typedef ::simd_int2 int2;
+typedef ::simd_int3 int3;
+typedef ::simd_int4 int4;
+typedef ::simd_uint2 uint2;
+typedef ::simd_uint3 uint3;
+typedef ::simd_uint4 uint4;
+
+struct float3x3 : ::simd_float3x3 {
+    constexpr float3x3() : ::simd_float3x3{} {}
+    constexpr explicit float3x3(float diagonal)
+    : ::simd_float3x3{{ {diagonal, 0, 0}, {0, diagonal, 0}, {0, 0, diagonal} }} {}
+    constexpr float3x3(float3 c0, float3 c1, float3 c2) : ::simd_float3x3{{ c0, c1, c2 }} {}
+    constexpr float3x3(const ::simd_float3x3& m) : ::simd_float3x3(m) {}
+};
+
+struct float4x4 : ::simd_float4x4 {
+    constexpr float4x4() : ::simd_float4x4{} {}
+    constexpr explicit float4x4(float diagonal)
+    : ::simd_float4x4{{ {diagonal, 0, 0, 0}, {0, diagonal, 0, 0}, {0, 0, diagonal, 0}, {0, 0, 0, diagonal} }} {}
+    constexpr float4x4(float4 c0, float4 c1, float4 c2, float4 c3) : ::simd_float4x4{{ c0, c1, c2, c3 }} {}
+    constexpr float4x4(const ::simd_float4x4& m) : ::simd_float4x4(m) {}
+};
+
+template <class T, int N>
+inline T reduce_add(detail::vector<T, N> a) {
+    if constexpr (N == 2) {
+        return a.x + a.y;
+    } else if constexpr (N == 3) {
+        return a.x + a.y + a.z;
+    } else {
+        return (a.x + a.y) + (a.z + a.w);
+    }
+}
+
+template <class T, int N>
+inline T dot(detail::vector<T, N> a, detail::vector<T, N> b) {
+    return reduce_add(a * b);
+}
+
+template <int N>
+inline float length_squared(detail::vector<float, N> a) {
+    return dot(a, a);
+}
+
+template <int N>
+inline float length(detail::vector<float, N> a) {
+    return sqrtf(length_squared(a));
+}
+
+template <int N>
+inline float distance_squared(detail::vector<float, N> a, detail::vector<float, N> b) {
+    return length_squared(a - b);
+}
+
+template <int N>
+inline float distance(detail::vector<float, N> a, detail::vector<float, N> b) {
+    return length(a - b);
+}
+
+template <int N>
+inline detail::vector<float, N> normalize(detail::vector<float, N> a) {
+    return a / length(a);
+}
+
+inline float3 cross(float3 a, float3 b) {
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+template <class T, int N>
+inline detail::vector<T, N> min(detail::vector<T, N> a, detail::vector<T, N> b) {
+    detail::vector<T, N> ret;
+    ret.v = a.v < b.v ? a.v : b.v;
+    return ret;
+}
+
+template <class T, int N>
+inline detail::vector<T, N> max(detail::vector<T, N> a, detail::vector<T, N> b) {
+    detail::vector<T, N> ret;
+    ret.v = a.v > b.v ? a.v : b.v;
+    return ret;
+}
+
+template <class T, int N>
+inline detail::vector<T, N> clamp(detail::vector<T, N> a, detail::vector<T, N> lo, detail::vector<T, N> hi) {
+    return min(max(a, lo), hi);
+}
+
+template <int N>
+inline detail::vector<float, N> abs(detail::vector<float, N> a) {
+    return max(a, -a);
+}
+
+template <int N>
+inline detail::vector<float, N> mix(detail::vector<float, N> a, detail::vector<float, N> b, float t) {
+    return a + (b - a) * t;
+}
+
+inline float4 mul(const ::simd_float4x4& m, float4 v) {
+    return m.columns[0] * v.x + m.columns[1] * v.y + m.columns[2] * v.z + m.columns[3] * v.w;
+}
+
+inline float3 mul(const ::simd_float3x3& m, float3 v) {
+    return m.columns[0] * v.x + m.columns[1] * v.y + m.columns[2] * v.z;
+}
+
+inline float4x4 mul(const ::simd_float4x4& a, const ::simd_float4x4& b) {
+    return { mul(a, b.columns[0]), mul(a, b.columns[1]), mul(a, b.columns[2]), mul(a, b.columns[3]) };
+}
+
+inline float3x3 mul(const ::simd_float3x3& a, const ::simd_float3x3& b) {
+    return { mul(a, b.columns[0]), mul(a, b.columns[1]), mul(a, b.columns[2]) };
+}
+
+inline float4x4 transpose(const ::simd_float4x4& m) {
+    const auto& c = m.columns;
+    return {
+        float4{ c[0].x, c[1].x, c[2].x, c[3].x },
+        float4{ c[0].y, c[1].y, c[2].y, c[3].y },
+        float4{ c[0].z, c[1].z, c[2].z, c[3].z },
+        float4{ c[0].w, c[1].w, c[2].w, c[3].w },
+    };
+}
+
+inline float4x4 operator*(const float4x4& a, const float4x4& b) { return mul(a, b); }
+inline float3x3 operator*(const float3x3& a, const float3x3& b) { return mul(a, b); }
+inline float4 operator*(const float4x4& m, float4 v) { return mul(m, v); }
+inline float3 operator*(const float3x3& m, float3 v) { return mul(m, v); }
+
+} /* namespace simd */
+
+inline simd_float4x4 simd_matrix(simd_float4 c0, simd_float4 c1, simd_float4 c2, simd_float4 c3) {
+    return simd_float4x4{{ c0, c1, c2, c3 }};
+}
+
+inline simd_float3x3 simd_matrix(simd_float3 c0, simd_float3 c1, simd_float3 c2) {
+    return simd_float3x3{{ c0, c1, c2 }};
+}
+
+inline simd_float4x4 simd_matrix_from_rows(simd_float4 r0, simd_float4 r1, simd_float4 r2, simd_float4 r3) {
+    return simd::transpose(simd_matrix(r0, r1, r2, r3));
+}
+
+inline simd_float4 simd_mul(simd_float4x4 m, simd_float4 v) { return simd::mul(m, v); }
+inline simd_float4x4 simd_mul(simd_float4x4 a, simd_float4x4 b) { return simd::mul(a, b); }
+inline float simd_distance(simd_float2 a, simd_float2 b) { return simd::distance(a, b); }
+
+static const simd_float4x4 matrix_identity_float4x4 = simd::float4x4(1.0f);
+static const simd_float3x3 matrix_identity_float3x3 = simd::float3x3(1.0f);
+
+#endif /* defined(__APPLE__) */
@@ -3,10 +3,13 @@
 #include <simd/simd.h>
 
 #include "../../Engine/Engine.hh"
+#include "../../Engine/Jobs.hh"
+#include "../../Engine/MetalUpload.hh"
+#include "../../Engine/Trace.hh"
 #include "../../Utility/Math.hh"
 
 #include "./ShaderTypes.hh"
-#include "./Scene.hh"
+#include "./Renderer.hh"
 
 namespace Scenes {
 namespace NavigateCube {
@@ -104,21 +107,20 @@ void Renderer::buildBuffers()
     vertexDataBuffer->didModifyRange( NS::Range::Make( 0, vertexDataBuffer->length() ) );
     indexBuffer->didModifyRange( NS::Range::Make( 0, indexBuffer->length() ) );
 
-    const size_t instanceDataSize = kMaxFramesInFlight * kNumInstances * sizeof( InstanceData );
-    for ( size_t i = 0; i < kMaxFramesInFlight; ++i ) {
-        instanceDataBuffers[ i ] = ns_ptr(device->newBuffer( instanceDataSize, MTL::ResourceStorageModeManaged ));
-    }
-
-    const size_t cameraDataSize = kMaxFramesInFlight * sizeof( CameraData );
-    for ( size_t i = 0; i < kMaxFramesInFlight; ++i ) {
-        cameraDataBuffers[ i ] = ns_ptr(device->newBuffer( cameraDataSize, MTL::ResourceStorageModeManaged ));
-    }
+    // What the frames in flight use, each allocation rounded up to the offset
+    // alignment, and one frame more. The semaphore bounds the frames in
+    // flight, but the ring learns that a frame completed from a handler of
+    // its own that may run after the semaphore's, and allocations never
+    // straddle the end of the buffer; the spare frame covers both, so that
+    // allocations rarely have to wait.
+    const auto aligned = [](size_t size) { return (size + 255) & ~size_t(255); };
+    const size_t frameDataSize = aligned( kNumInstances * sizeof( InstanceData ) ) + aligned( sizeof( CameraData ) );
+    uploads = std::make_unique<Engine::MetalUploadRing>( device.get(), (kMaxFramesInFlight + 1) * frameDataSize );
 }
 
 Renderer::Renderer(MTK::View *mtkView, Scene& scene)
 : scene(scene)
-, angle(0.f)
-, frame(0) {
+, angle(0.f) {
     mtkView->setColorPixelFormat( MTL::PixelFormat::PixelFormatBGRA8Unorm_sRGB );
     mtkView->setClearColor( MTL::ClearColor::Make( 0.1, 0.1, 0.1, 1.0 ) );
     mtkView->setDepthStencilPixelFormat( MTL::PixelFormat::PixelFormatDepth16Unorm );
@@ -139,13 +141,17 @@ Renderer::Renderer(MTK::View *mtkView, Scene& scene)
 Renderer::~Renderer() {}
 
 void Renderer::drawInMTKView(MTK::View* view) {
+    TRACE_ZONE("Renderer::drawInMTKView");
     auto pool = NS::AutoreleasePool::alloc()->init();
     auto renderPassDesc = view->currentRenderPassDescriptor();
     
     if (renderPassDesc != nullptr) {
         auto cmdBuffer = q->commandBuffer();
         cmdBuffer->setLabel(NSExt::UTF8String("MyCommand"));
-        dispatch_semaphore_wait( semaphore, DISPATCH_TIME_FOREVER );
+        {
+            TRACE_ZONE("Renderer::waitForFrame");
+            dispatch_semaphore_wait( semaphore, DISPATCH_TIME_FOREVER );
+        }
         Renderer* renderer = this;
         cmdBuffer->addCompletedHandler( ^void( MTL::CommandBuffer* pCmd ){
             dispatch_semaphore_signal( renderer->semaphore );
@@ -165,12 +171,22 @@ void Renderer::drawInMTKView(MTK::View* view) {
         using simd::float3;
         angle += 0.002f;
 
-        // Update instance positions:
-        frame = (frame + 1) % Renderer::kMaxFramesInFlight;
-        auto instanceDataBuffer = instanceDataBuffers[ frame ];
+        auto instanceData = uploads->allocate( kNumInstances * sizeof( InstanceData ) );
+        auto cameraData = uploads->allocate( sizeof( CameraData ) );
+        if ( !instanceData || !cameraData )
+        {
+            // Only when the ring cannot hold one frame's data: nothing to draw with.
+            enc->endEncoding();
+            uploads->commit(cmdBuffer);
+            cmdBuffer->presentDrawable(view->currentDrawable());
+            cmdBuffer->commit();
+            pool->release();
+            return;
+        }
 
+        // Update instance positions:
         const float scl = 0.2f;
-        InstanceData* pInstanceData = reinterpret_cast< InstanceData *>( instanceDataBuffer->contents() );
+        InstanceData* pInstanceData = reinterpret_cast< InstanceData *>( instanceData.data );
 
         float3 objectPosition = { 0.f, 0.f, -10.f };
 
@@ -180,60 +196,52 @@ void Renderer::drawInMTKView(MTK::View* view) {
 //        float4x4 rtInv = Math::makeTranslate( { -objectPosition.x, -objectPosition.y, -objectPosition.z } );
 //        float4x4 fullObjectRot = rt * rr1 * rr0 * rtInv;
 
-        size_t ix = 0;
-        size_t iy = 0;
-        size_t iz = 0;
-        for ( size_t i = 0; i < kNumInstances; ++i )
         {
-            if ( ix == kInstanceRows )
-            {
-                ix = 0;
-                iy += 1;
-            }
-            if ( iy == kInstanceRows )
-            {
-                iy = 0;
-                iz += 1;
-            }
-
-            float4x4 scale = Math::makeScale( (float3){ scl, scl, scl } );
-            float4x4 zrot = Math::makeZRotate( angle * sinf((float)ix) );
-            float4x4 yrot = Math::makeYRotate( angle * cosf((float)iy));
-
-            float x = ((float)ix - (float)kInstanceRows/2.f) * (2.f * scl) + scl;
-            float y = ((float)iy - (float)kInstanceColumns/2.f) * (2.f * scl) + scl;
-            float z = ((float)iz - (float)kInstanceDepth/2.f) * (2.f * scl);
-            float4x4 translate = Math::makeTranslate( Math::add( objectPosition, { x, y, z } ) );
-
-            //pInstanceData[ i ].instanceTransform = fullObjectRot * translate * yrot * zrot * scale;
-            pInstanceData[ i ].instanceTransform = translate * yrot * zrot * scale;
-            pInstanceData[ i ].instanceNormalTransform = Math::discardTranslation( pInstanceData[ i ].instanceTransform );
-
-            float iDivNumInstances = i / (float)kNumInstances;
-            float r = iDivNumInstances;
-            float g = 1.0f - r;
-            float b = sinf( M_PI * 2.0f * iDivNumInstances );
-            pInstanceData[ i ].instanceColor = (float4){ r, g, b, 1.0f };
-
-            ix += 1;
+            TRACE_ZONE("Renderer::updateInstances");
+            // Instances are independent, so they are filled in parallel; the
+            // grid position is derived from the index instead of counted.
+            Engine::JobSystem::shared().parallelFor(0, kNumInstances, 64, [&](size_t begin, size_t end) {
+                for ( size_t i = begin; i < end; ++i )
+                {
+                    const size_t ix = i % kInstanceRows;
+                    const size_t iy = i / kInstanceRows % kInstanceRows;
+                    const size_t iz = i / (kInstanceRows * kInstanceRows);
+
+                    float4x4 scale = Math::makeScale( (float3){ scl, scl, scl } );
+                    float4x4 zrot = Math::makeZRotate( angle * sinf((float)ix) );
+                    float4x4 yrot = Math::makeYRotate( angle * cosf((float)iy));
+
+                    float x = ((float)ix - (float)kInstanceRows/2.f) * (2.f * scl) + scl;
+                    float y = ((float)iy - (float)kInstanceColumns/2.f) * (2.f * scl) + scl;
+                    float z = ((float)iz - (float)kInstanceDepth/2.f) * (2.f * scl);
+                    float4x4 translate = Math::makeTranslate( Math::add( objectPosition, { x, y, z } ) );
+
+                    //pInstanceData[ i ].instanceTransform = fullObjectRot * translate * yrot * zrot * scale;
+                    pInstanceData[ i ].instanceTransform = translate * yrot * zrot * scale;
+                    pInstanceData[ i ].instanceNormalTransform = Math::discardTranslation( pInstanceData[ i ].instanceTransform );
+
+                    float iDivNumInstances = i / (float)kNumInstances;
+                    float r = iDivNumInstances;
+                    float g = 1.0f - r;
+                    float b = sinf( M_PI * 2.0f * iDivNumInstances );
+                    pInstanceData[ i ].instanceColor = (float4){ r, g, b, 1.0f };
+                }
+            });
         }
-        instanceDataBuffer->didModifyRange( NS::Range::Make( 0, instanceDataBuffer->length() ) );
 
         // Update camera state:
 
-        auto pCameraDataBuffer = cameraDataBuffers[ frame ];
-        CameraData* pCameraData = reinterpret_cast< CameraData *>( pCameraDataBuffer->contents() );
+        CameraData* pCameraData = reinterpret_cast< CameraData *>( cameraData.data );
         pCameraData->perspectiveTransform = Math::makePerspective( 45.f * M_PI / 180.f, 1.f, 0.03f, 500.0f ) ;
         pCameraData->worldTransform = Math::makeIdentity();
         pCameraData->worldNormalTransform = Math::discardTranslation( pCameraData->worldTransform );
-        pCameraDataBuffer->didModifyRange( NS::Range::Make( 0, sizeof( CameraData ) ) );
 
         enc->setRenderPipelineState( state.get() );
         enc->setDepthStencilState( depthStencilState.get() );
 
         enc->setVertexBuffer( vertexDataBuffer.get(), /* offset */ 0, /* index */ 0 );
-        enc->setVertexBuffer( instanceDataBuffer.get(), /* offset */ 0, /* index */ 1 );
-        enc->setVertexBuffer( pCameraDataBuffer.get(), /* offset */ 0, /* index */ 2 );
+        enc->setVertexBuffer( uploads->buffer(), instanceData.offset, /* index */ 1 );
+        enc->setVertexBuffer( uploads->buffer(), cameraData.offset, /* index */ 2 );
 
         enc->setCullMode( MTL::CullModeBack );
         enc->setFrontFacingWinding( MTL::Winding::WindingCounterClockwise );
@@ -245,6 +253,7 @@ void Renderer::drawInMTKView(MTK::View* view) {
                                     kNumInstances );
 
         enc->endEncoding();
+        uploads->commit(cmdBuffer);
         cmdBuffer->presentDrawable(view->currentDrawable());
         cmdBuffer->commit();
     }
@@ -256,6 +265,10 @@ void Renderer::drawableSizeWillChange(MTK::View* view, CGSize size) {
     viewport.y = size.height;
 }
 
+Engine::Renderer* Scene::createRenderer(MTK::View* mtkView) {
+    return new Renderer(mtkView, *this);
+}
+
 } /* namespace NavigateCube */
 } /* namespace Scenes */
 
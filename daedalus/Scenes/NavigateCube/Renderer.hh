@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QuartzCore/QuartzCore.h>
+#include <MetalKit/MetalKit.hpp>
+#include <memory>
+#include "../../Utility/AppKitExt.hh"
+#include "../../Engine/Engine.hh"
+#include "../../Engine/CommandList.hh"
+#include "./Scene.hh"
+
+namespace Engine { class MetalUploadRing; }
+
+namespace Scenes {
+namespace NavigateCube {
+
+using namespace NSExt;
+
+struct Renderer : public Engine::Renderer {
+    Renderer(MTK::View* mtkView, Scene& scene);
+    virtual void drawInMTKView(MTK::View* view) override;
+    virtual void drawableSizeWillChange(MTK::View* view, CGSize size) override;
+    virtual ~Renderer() override;
+    
+    static constexpr size_t kMaxFramesInFlight = 3;
+    static constexpr size_t kInstanceRows = 10;
+    static constexpr size_t kInstanceColumns = 10;
+    static constexpr size_t kInstanceDepth = 10;
+    static constexpr size_t kNumInstances = (kInstanceRows * kInstanceColumns * kInstanceDepth);
+private:
+    void buildShaders();
+    void buildDepthStencilStates();
+    void buildBuffers();
+    ns_ptr<MTL::Device> device;
+    ns_ptr<MTL::CommandQueue> q;
+    ns_ptr<MTL::RenderPipelineState> state;
+    ns_ptr<MTL::Library> library;
+    ns_ptr<MTL::DepthStencilState> depthStencilState;
+    ns_ptr<MTL::Buffer> vertexDataBuffer;
+    // Instance and camera data of the frames in flight.
+    std::unique_ptr<Engine::MetalUploadRing> uploads;
+    ns_ptr<MTL::Buffer> indexBuffer;
+    float angle;
+    dispatch_semaphore_t semaphore;
+    simd_uint2 viewport;
+    Scene& scene;
+};
+
+} /* namespace NavigateCube */
+} /* namespace Scenes */
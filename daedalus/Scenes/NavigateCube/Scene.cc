@@ -14,10 +14,10 @@ namespace NavigateCube {
  */
 
 
-void Scene::onDraw(MTL::RenderCommandEncoder* enc) {
+void Scene::onDraw(Engine::CommandList& commands) {
 }
 
-void Scene::onInit(CFTimeInterval t) {
+void Scene::onInit(const Engine::FrameContext& frame) {
 }
 
 void Scene::onMouseClicked(Engine::Input::MouseButton button, Engine::Input::ButtonState buttonState, simd::float2 c) {
@@ -31,11 +31,7 @@ bool Scene::onKey(Engine::Input::KeyboardButton button, Engine::Input::ButtonSta
 void Scene::onMouseMoved(simd::float2 c) {
 }
 
-void Scene::onIdle(CFTimeInterval endT) {
-}
-
-Engine::Renderer* Scene::createRenderer(MTK::View* mtkView) {
-    return new Renderer(mtkView, *this);
+void Scene::onIdle(const Engine::FrameContext& frame) {
 }
 
 } /* namespace NavigateCube */
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+
+#include "../Engine/Engine.hh"
+#include "../Engine/SoftwareRenderer.hh"
+#include "./S13E01/Scene.hh"
+#include "./S13E01/SoftwareShaders.hh"
+#include "./S13E02/Scene.hh"
+#include "./S13E02/SoftwareShaders.hh"
+#include "./NavigateCube/Scene.hh"
+
+// Every scene, in the order of the app's Scenes menu. The app and the
+// headless runner both create scenes from here.
+namespace Scenes {
+
+struct Registration {
+    const char* name;
+    std::unique_ptr<Engine::Scene> (*make)();
+    // C++ counterparts of the scene's shaders, null for scenes that draw
+    // only in their Metal renderer.
+    const Engine::Software::Program* (*program)();
+};
+
+namespace detail {
+    template <class S>
+    std::unique_ptr<Engine::Scene> make() {
+        return std::make_unique<S>();
+    }
+}
+
+inline constexpr Registration registry[] = {
+    {"S13E01", detail::make<S13E01::Scene>, [] { return &S13E01::Software::program(); }},
+    {"S13E02", detail::make<S13E02::Scene>, [] { return &S13E02::Software::program(); }},
+    {"NavigateCube", detail::make<NavigateCube::Scene>, nullptr},
+};
+
+inline const Registration* find(std::string_view name) {
+    for (const auto& registration : registry) {
+        if (name == registration.name) {
+            return &registration;
+        }
+    }
+    return nullptr;
+}
+
+} /* namespace Scenes */
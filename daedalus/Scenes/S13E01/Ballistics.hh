@@ -0,0 +1,163 @@
+#pragma once
+
+#include <simd/simd.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <optional>
+
+namespace Scenes {
+namespace S13E01 {
+
+// Path under constant acceleration, p(t) = p0 + v0 t + a t^2 / 2, t in
+// seconds. Without drag this is exactly how the launched bird flies, so its
+// position is evaluated rather than integrated.
+struct Parabola {
+    simd::float2 p0;
+    simd::float2 v0;
+    simd::float2 a;
+
+    simd::float2 position(float t) const {
+        return p0 + (v0 + a * (t / 2)) * t;
+    }
+
+    simd::float2 velocity(float t) const {
+        return v0 + a * t;
+    }
+};
+
+// Smallest t >= 0 at which p0 + v t + a t^2 / 2 equals c, infinity if it
+// never does. The roots are taken in the form that does not cancel.
+inline float firstCrossing(float p0, float v, float a, float c) {
+    constexpr float never = std::numeric_limits<float>::infinity();
+    const float A = a / 2, B = v, C = p0 - c;
+    if (!std::isfinite(c)) {
+        return never;
+    }
+    if (A == 0) {
+        const float t = B != 0 ? -C / B : never;
+        return t >= 0 ? t : never;
+    }
+    const float discriminant = B * B - 4 * A * C;
+    if (discriminant < 0) {
+        return never;
+    }
+    const float q = -(B + std::copysign(std::sqrt(discriminant), B)) / 2;
+    float t0 = q / A, t1 = q != 0 ? C / q : 0;
+    if (t0 > t1) {
+        std::swap(t0, t1);
+    }
+    return t0 >= 0 ? t0 : t1 >= 0 ? t1 : never;
+}
+
+// First t >= 0 at which path leaves the box [low, high]. Infinite bounds
+// are never left.
+inline float exitTime(const Parabola& path, simd::float2 low, simd::float2 high) {
+    float t = std::numeric_limits<float>::infinity();
+    for (int i = 0; i < 2; ++i) {
+        t = std::min(t, firstCrossing(path.p0[i], path.v0[i], path.a[i], low[i]));
+        t = std::min(t, firstCrossing(path.p0[i], path.v0[i], path.a[i], high[i]));
+    }
+    return t;
+}
+
+// Oscillation about center, center + amplitude sin(2 pi frequency t), t in
+// seconds of engine time.
+struct Hover {
+    simd::float2 center;
+    simd::float2 amplitude;
+    double frequency;
+
+    simd::float2 position(double t) const {
+        return center + amplitude * float(std::sin(2 * std::numbers::pi * frequency * t));
+    }
+
+    // Largest |velocity| of each coordinate.
+    simd::float2 maxSpeed() const {
+        return simd::abs(amplitude) * float(2 * std::numbers::pi * frequency);
+    }
+};
+
+// A bird let go of at release. The band pulls it straight toward the fork,
+// at stiffness times the distance it was pulled per second, until it is
+// within clearance of the fork; from there it flies free under gravity.
+// Times are in seconds since release.
+struct Launch {
+    simd::float2 release;
+    simd::float2 velocity;
+    simd::float2 gravity;
+    float clearTime;
+
+    static Launch make(simd::float2 release, simd::float2 fork, float stiffness, float clearance, simd::float2 gravity) {
+        const auto pull = fork - release;
+        const float distance = simd::length(pull);
+        const float clearTime = distance > clearance ? (distance - clearance) / (stiffness * distance) : 0;
+        return Launch{release, pull * stiffness, gravity, clearTime};
+    }
+
+    bool inBand(float t) const {
+        return t < clearTime;
+    }
+
+    Parabola flight() const {
+        return Parabola{release + velocity * clearTime, velocity, gravity};
+    }
+
+    simd::float2 position(float t) const {
+        return inBand(t) ? release + velocity * t : flight().position(t - clearTime);
+    }
+};
+
+// First time in [begin, end] at which a body on path touches one hovering,
+// both axis-aligned ellipses with radii r; the hover is at origin + t when
+// the body is at t. Two such ellipses touch when their centers are 2r apart
+// in the metric of r, since the Minkowski sum of the ellipse with itself is
+// the ellipse scaled by two.
+//
+// Conservative advancement: that separation shrinks no faster than the
+// bound on the relative velocity, so a step of separation / bound cannot
+// pass the first contact. Contacts shorter than minStep may be missed. An
+// unbounded interval, as when the path never leaves the screen, has no
+// velocity bound and finds nothing; so does one where t gets too large for
+// steps to move it.
+inline std::optional<float> impact(const Parabola& path,
+                                   const Hover& hover,
+                                   double origin,
+                                   simd::float2 r,
+                                   float begin,
+                                   float end,
+                                   float tolerance = 1e-4f,
+                                   float minStep = 1e-4f
+                                   ) {
+    if (!std::isfinite(begin) || !std::isfinite(end)) {
+        return std::nullopt;
+    }
+    const auto scale = 1 / (2 * r);
+    auto separation = [&](float t) {
+        return simd::length((path.position(t) - hover.position(origin + t)) * scale) - 1;
+    };
+    // Velocity is linear in t, so its largest magnitude is at an end.
+    const auto speed = simd::max(simd::abs(path.velocity(begin)), simd::abs(path.velocity(end))) + hover.maxSpeed();
+    const float bound = simd::reduce_add(speed * scale);
+
+    for (float t = begin; t <= end;) {
+        const float s = separation(t);
+        if (s <= tolerance) {
+            return t;
+        }
+        if (bound <= 0) {
+            break;
+        }
+        const float next = t + std::max(s / bound, minStep);
+        // Far enough out, a step no longer moves t.
+        if (next <= t) {
+            break;
+        }
+        t = next;
+    }
+    return std::nullopt;
+}
+
+} /* namespace S13E01 */
+} /* namespace Scenes */
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <simd/simd.h>
+
+#include "../../Engine/CommandList.hh"
+
+namespace Scenes {
+namespace S13E01 {
+
+// Pipelines draw commands are recorded with, indexing the renderer's states.
+namespace Pipeline {
+constexpr Engine::PipelineId Primitives = 0;
+constexpr Engine::PipelineId Ellipses = 1;
+constexpr Engine::PipelineId Triangles = 2;
+constexpr size_t Count = 3;
+} /* namespace Pipeline */
+
+// Linear color the render target is cleared to.
+constexpr simd::float4 ClearColor{0.1f, 0.1f, 0.1f, 1.0f};
+
+} /* namespace S13E01 */
+} /* namespace Scenes */
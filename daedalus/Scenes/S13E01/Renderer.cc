@@ -3,8 +3,11 @@
 #include <simd/simd.h>
 
 #include "../../Engine/Engine.hh"
+#include "../../Engine/MetalReplay.hh"
+#include "../../Engine/Trace.hh"
 
-#include "./Scene.hh"
+#include "./Renderer.hh"
+#include "./ShaderTypes.hh"
 
 namespace Scenes {
 namespace S13E01 {
@@ -13,7 +16,7 @@ Renderer::Renderer(MTK::View *mtkView, Scene& scene): scene(scene) {
     NS::Error* err = nullptr;
     
     mtkView->setColorPixelFormat( MTL::PixelFormat::PixelFormatBGRA8Unorm_sRGB );
-    mtkView->setClearColor( MTL::ClearColor::Make( 0.1, 0.1, 0.1, 1.0 ) );
+    mtkView->setClearColor( MTL::ClearColor::Make( ClearColor.x, ClearColor.y, ClearColor.z, ClearColor.w ) );
     
     device = mtkView->device()->retain();
     
@@ -41,6 +44,9 @@ Renderer::Renderer(MTK::View *mtkView, Scene& scene): scene(scene) {
         assert( false );
     }
 
+    ellipseState = Engine::makePipeline(device, library, "Scenes::S13E01::ellipseVertexShader", "Scenes::S13E01::fragmentShader", mtkView->colorPixelFormat());
+    triangleState = Engine::makePipeline(device, library, "Scenes::S13E01::triangleVertexShader", "Scenes::S13E01::fragmentShader", mtkView->colorPixelFormat());
+
     q = device->newCommandQueue();
     
     vertexShader->release();
@@ -51,11 +57,14 @@ Renderer::Renderer(MTK::View *mtkView, Scene& scene): scene(scene) {
 
 Renderer::~Renderer() {
     q->release();
+    triangleState->release();
+    ellipseState->release();
     state->release();
     device->release();
 }
 
 void Renderer::drawInMTKView(MTK::View* view) {
+    TRACE_ZONE("Renderer::drawInMTKView");
     auto pool = NS::AutoreleasePool::alloc()->init();
     
     auto cmdBuffer = q->commandBuffer();
@@ -71,10 +80,23 @@ void Renderer::drawInMTKView(MTK::View* view) {
             .zfar=1.0
         });
         
-        enc->setRenderPipelineState(state);
+        {
+            TRACE_ZONE("Scene::onDraw");
+            commands.reset();
+            scene.onDraw(commands);
+        }
         
-        scene.onDraw(enc);
+        {
+            TRACE_ZONE("Engine::replay");
+            MTL::RenderPipelineState* const pipelines[Pipeline::Count] = {state, ellipseState, triangleState};
+            Engine::replay(enc, commands, pipelines, Engine::Bindings{
+                .vertices=(uint8_t)VertexInputIndex::Vertices,
+                .color=(uint8_t)VertexInputIndex::Color,
+                .instances=(uint8_t)VertexInputIndex::Instances
+            });
+        }
         
+        TRACE_ZONE("Renderer::commit");
         enc->endEncoding();
         cmdBuffer->presentDrawable(view->currentDrawable());
         cmdBuffer->commit();
@@ -87,5 +109,9 @@ void Renderer::drawableSizeWillChange(MTK::View* view, CGSize size) {
     viewport.y = size.height;
 }
 
+Engine::Renderer* Scene::createRenderer(MTK::View* mtkView) {
+    return new Renderer(mtkView, *this);
+}
+
 } /* namespace S13E01 */
 } /* namespace Scenes */
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <MetalKit/MetalKit.hpp>
+#include "../../Engine/Engine.hh"
+#include "../../Engine/CommandList.hh"
+#include "./Scene.hh"
+
+namespace Scenes {
+namespace S13E01 {
+
+struct Renderer : public Engine::Renderer {
+    Renderer(MTK::View* mtkView, Scene& scene);
+    virtual void drawInMTKView(MTK::View* view) override;
+    virtual void drawableSizeWillChange(MTK::View* view, CGSize size) override;
+    virtual ~Renderer() override;
+private:
+    MTL::Device* device;
+    MTL::CommandQueue* q;
+    MTL::RenderPipelineState* state;
+    MTL::RenderPipelineState* ellipseState;
+    MTL::RenderPipelineState* triangleState;
+    Engine::CommandList commands;
+    simd_uint2 viewport;
+    Scene& scene;
+};
+
+} /* namespace S13E01 */
+} /* namespace Scenes */
@@ -1,12 +1,17 @@
 #include <vector>
 #include <array>
+#include <limits>
 #include <type_traits>
 #include <simd/simd.h>
 
-#include "../../Utility/AppKitExt.hh"
+#include "../../Utility/Shapes.hh"
+#include "../../Utility/Collision.hh"
+#include "../../Engine/Handoff.hh"
+#include "../../Engine/FixedStep.hh"
 
 #include "Scene.hh"
 #include "ShaderTypes.hh"
+#include "Ballistics.hh"
 
 namespace Scenes {
 /*
@@ -39,35 +44,13 @@ namespace Scenes {
  */
 namespace S13E01 {
 
-template <size_t N>
-void drawPrimitive(MTL::RenderCommandEncoder* enc,
-                   const std::array<simd::float2, N>& vertices,
+INLINE
+void drawPrimitive(Engine::CommandList& commands,
+                   std::span<const simd::float2> vertices,
                    const simd::float3& color,
-                   MTL::PrimitiveType primitiveType = MTL::PrimitiveType::PrimitiveTypeTriangleStrip
+                   Engine::PrimitiveType primitiveType = Engine::PrimitiveType::TriangleStrip
                    ) {
-    enc->setVertexBytes(vertices.data(), sizeof(vertices), (NS::UInteger)VertexInputIndex::Vertices);
-    enc->setVertexBytes(&color, sizeof(color), (NS::UInteger)VertexInputIndex::Color);
-    enc->drawPrimitives(primitiveType, NS::UInteger(0), NS::UInteger(vertices.size()));
-}
-
-template <size_t N>
-void drawEllipse(MTL::RenderCommandEncoder* enc,
-                 const simd::float2& p,
-                 const simd::float2& position,
-                 const simd::float3& color
-                 ) {
-    std::array<simd::float2, 2 * N + 1> vertices;
-    const float angleIncrement = 2.0f * M_PI / N;
-    for (auto i = 0; i < N; ++i) {
-        float angle = i * angleIncrement;
-        vertices[2 * i] = {
-            position.x + cosf(angle) * p.x,
-            position.y + sinf(angle) * p.y,
-        };
-        vertices[2 * i + 1] = { position.x, position.y };
-    }
-    vertices[2 * N] = { position.x + p.x, position.y};
-    drawPrimitive(enc, vertices, color);
+    commands.draw(Pipeline::Primitives, primitiveType, vertices, color);
 }
 
 namespace Colors {
@@ -80,7 +63,13 @@ constexpr simd::float2 scaleToViewport(simd::float2 norm) {
     return norm * 300;
 }
 
+// The simulation runs in fixed steps of dt whatever the display rate, and
+// onDraw interpolates between the last two. A frame runs at most
+// maxStepsPerFrame steps; after a longer stall the birds slow down rather
+// than the frames. Each step evaluates the flight in closed form at its end,
+// so dt only decides when hits and respawns take effect, not the path.
 constexpr double dt = 1.0 / 90;
+constexpr unsigned maxStepsPerFrame = 8;
 
 const simd::float2 viewport{600, 600};
 
@@ -116,7 +105,20 @@ const std::array<simd::float2, 4> slingshotFrontVertices{{
     {183, 270},
 }};
 const simd::float2 launchPosition{200, 200};
-const simd::float2 gravity{0.0f,-60.0f};
+// In pixels per second squared.
+const simd::float2 gravity{0.0f,-5400.0f};
+// Launch speed in pixels per second for each pixel the band is pulled, and
+// how close to the fork the band lets go.
+constexpr float bandStiffness = 7.0f;
+constexpr float bandClearance = 20.0f;
+// The green bird's flight, in engine time.
+const Hover hover{simd::float2{525,300}, simd::float2{0,210}, 0.5};
+// The red bird is gone once it leaves this box.
+const simd::float2 boundsLow{-60, -120};
+const simd::float2 boundsHigh{660, std::numeric_limits<float>::infinity()};
+// Dots of the trajectory preview while dragging.
+constexpr float previewInterval = 1.0f / 30;
+constexpr int maxPreviewDots = 60;
 
 enum class State{
     Idle,
@@ -133,59 +135,42 @@ constexpr simd::float2 UpsideDown = {1, -1};
 } /* namespace Facing */
 
 struct Bird {
-    static constexpr size_t BodyResolution = 30;
     static constexpr simd::float2 p = {30.f, 60.f};
     
     simd::float2 position;
     simd::float3 color;
     simd::float2 facing;
     
-    void draw(MTL::RenderCommandEncoder* enc) const;
-    bool intersect(const Bird& anotherBird) const;
+    void draw(Shapes::Layer& layer) const;
+    Collision::Ellipse body() const;
     bool intersect(const simd::float2& vertex) const;
 };
 
-void Bird::draw(MTL::RenderCommandEncoder* enc) const {
+void Bird::draw(Shapes::Layer& layer) const {
+    auto at = [&](simd::float2 local) { return position + p * local * facing; };
+    
     // tail
-    drawPrimitive(enc, std::array<simd::float2, 6> {
-        simd::float2{position + p * simd::float2{-0.7f, 0.0f} * facing},
-        simd::float2{position + p * simd::float2{-1.2f, 0.8f} * facing},
-        simd::float2{position + p * simd::float2{-1.2f, 0.15f} * facing},
-        simd::float2{position + p * simd::float2{-0.7f, 0.0f} * facing},
-        simd::float2{position + p * simd::float2{-1.2f, 0.8f} * facing},
-        simd::float2{position + p * simd::float2{-1.2f, -0.15f} * facing},
-    }, Colors::black, MTL::PrimitiveType::PrimitiveTypeTriangle);
+    layer.triangle(at({-0.7f, 0.0f}), at({-1.2f, 0.8f}), at({-1.2f, 0.15f}), Colors::black, Shapes::Layer::Depth::Under);
+    layer.triangle(at({-0.7f, 0.0f}), at({-1.2f, 0.8f}), at({-1.2f, -0.15f}), Colors::black, Shapes::Layer::Depth::Under);
     
-    drawEllipse<Bird::BodyResolution>(enc, p, position, color);
+    layer.ellipse(position, p, color, facing);
     
     // eyes
-    drawEllipse<Bird::BodyResolution>(enc, p * 0.4, position + p * 0.5 * facing, Colors::white);
-    drawEllipse<Bird::BodyResolution>(enc, p * 0.4, position + p * simd::float2{-0.1f, 0.5f} * facing, Colors::white);
-    drawEllipse<Bird::BodyResolution>(enc, p * 0.2, position + p * 0.6 * facing, Colors::black);
-    drawEllipse<Bird::BodyResolution>(enc, p * 0.2, position + p * simd::float2{0.0f, 0.6f} * facing, Colors::black);
+    layer.ellipse(at({0.5f, 0.5f}), p * 0.4, Colors::white, facing);
+    layer.ellipse(at({-0.1f, 0.5f}), p * 0.4, Colors::white, facing);
+    layer.ellipse(at({0.6f, 0.6f}), p * 0.2, Colors::black, facing);
+    layer.ellipse(at({0.0f, 0.6f}), p * 0.2, Colors::black, facing);
     
     // beak
-    drawPrimitive(enc, std::array<simd::float2, 3> {
-        simd::float2{position + p * simd::float2{0.2f, 0.1f} * facing},
-        simd::float2{position + p * simd::float2{0.2f, -0.1f} * facing},
-        simd::float2{position + p * simd::float2{1.f, 0.0f} * facing},
-    }, Colors::yellow);
+    layer.triangle(at({0.2f, 0.1f}), at({0.2f, -0.1f}), at({1.f, 0.0f}), Colors::yellow);
     
     // eyebrows
-    drawPrimitive(enc, std::array<simd::float2, 6> {
-        simd::float2{position + p * simd::float2{0.6f, 0.8f} * facing},
-        simd::float2{position + p * simd::float2{1.4f, 0.6f} * facing},
-        simd::float2{position + p * simd::float2{0.6f, 1.0f} * facing},
-        simd::float2{position + p * simd::float2{-0.1f, 1.0f} * facing},
-        simd::float2{position + p * simd::float2{-0.9f, 0.6f} * facing},
-        simd::float2{position + p * simd::float2{-0.1f, 0.8f} * facing},
-    }, Colors::black, MTL::PrimitiveType::PrimitiveTypeTriangle);
+    layer.triangle(at({0.6f, 0.8f}), at({1.4f, 0.6f}), at({0.6f, 1.0f}), Colors::black);
+    layer.triangle(at({-0.1f, 1.0f}), at({-0.9f, 0.6f}), at({-0.1f, 0.8f}), Colors::black);
 }
 
-bool Bird::intersect(const Bird& anotherBird) const {
-    float d = (position.x - anotherBird.position.x) * (position.x - anotherBird.position.x) / (p.x * p.x) +
-    (position.y - anotherBird.position.y) * (position.y - anotherBird.position.y) / (p.y * p.y);
-    return d <= 4;
+Collision::Ellipse Bird::body() const {
+    return Collision::Ellipse{position, p};
 }
 
 bool Bird::intersect(const simd::float2& vertex) const {
@@ -194,25 +179,90 @@ bool Bird::intersect(const simd::float2& vertex) const {
     return d <= 1;
 }
 
+// How a launch ends: with a hit or leaving the screen, at end seconds
+// after release.
+struct Outcome {
+    float end;
+    bool hit;
+};
+
+// Solved once at release, against where the green bird will be.
+Outcome predict(const Launch& launch, Engine::Ticks releaseT) {
+    const auto flight = launch.flight();
+    const float exit = exitTime(flight, boundsLow, boundsHigh);
+    const auto hit = impact(flight, hover, Engine::seconds(releaseT) + launch.clearTime, Bird::p, 0, exit);
+    return hit ? Outcome{launch.clearTime + *hit, true} : Outcome{launch.clearTime + exit, false};
+}
+
+// What onDraw needs of the simulation: the state after the last step, where
+// the birds were before it, and how far the frame is between the two. While
+// dragging, also the launch that letting go now would make, up to where it
+// would end.
+struct Snapshot {
+    State state;
+    Bird target;
+    Bird missile;
+    simd::float2 previousTarget;
+    simd::float2 previousMissile;
+    float alpha;
+    Launch preview{};
+    float previewEnd = 0;
+};
+
+// Simulation state, only touched by onInit and onIdle. Input callbacks
+// queue their events for the next onIdle, which publishes a snapshot for
+// onDraw, so the two threads share nothing else. Times are simulation
+// times, which fall behind the frames' after a stall. In flight the birds
+// are evaluated at each step's time, and nothing changes between the launch
+// and its outcome.
 State state;
-simd::float2 launchVelocity;
-simd::float2 velocity;
 simd::float2 grabOffset;
-CFTimeInterval startT;
-CFTimeInterval launchT;
+Engine::FixedStep fixed(Engine::ticks(dt), maxStepsPerFrame);
+Launch launch;
+Engine::Ticks releaseT;
+Outcome outcome;
 Bird target;
 Bird missile;
+// Bird positions before the last step.
+simd::float2 previousTarget;
+simd::float2 previousMissile;
+Engine::Mailbox<Engine::Input::Event, 64> input;
+Engine::TripleBuffer<Snapshot> snapshots;
+
+// Owned by onDraw. A layer draws all its triangles under and over all its
+// ellipses, so each bird gets its own, drawn in turn: a bird's beak and
+// eyebrows must not end up on top of the bird in front of it.
+std::array<Shapes::Layer, 2> layers;
 
-void Scene::onInit(CFTimeInterval t) {
+void publish(Engine::Ticks t) {
+    auto& snapshot = snapshots.back();
+    snapshot = Snapshot{state, target, missile, previousTarget, previousMissile, fixed.alpha()};
+    if (state == State::Dragging) {
+        snapshot.preview = Launch::make(missile.position, launchPosition, bandStiffness, bandClearance, gravity);
+        snapshot.previewEnd = predict(snapshot.preview, t).end;
+    }
+    snapshots.publish();
+}
+
+// For jumps, which must not be interpolated across.
+void snap() {
+    previousTarget = target.position;
+    previousMissile = missile.position;
+}
+
+void Scene::onInit(const Engine::FrameContext& frame) {
     state = State::Idle;
-    target = {simd::float2{525,300}, simd::float3{0,0.5f,0}, Facing::Left};
+    target = {hover.position(frame.seconds()), simd::float3{0,0.5f,0}, Facing::Left};
     missile = {launchPosition, simd::float3{0.5f,0,0}, Facing::Right};
-    startT = t;
+    fixed.reset(frame.time);
+    snap();
+    publish(frame.time);
 }
 
-void Scene::onMouseClicked(Engine::Input::MouseButton button,
-                           Engine::Input::ButtonState buttonState,
-                           simd::float2 c) {
+void click(Engine::Input::MouseButton button,
+           Engine::Input::ButtonState buttonState,
+           simd::float2 c,
+           Engine::Ticks t) {
     if (button == Engine::Input::MouseButton::Left &&
         buttonState == Engine::Input::ButtonState::Down &&
         state == State::Idle
@@ -227,99 +277,147 @@ void Scene::onMouseClicked(Engine::Input::MouseButton button,
         buttonState == Engine::Input::ButtonState::Up &&
         state == State::Dragging
         ) {
-        launchVelocity = (launchPosition - missile.position) * 7.0f * dt;
+        launch = Launch::make(missile.position, launchPosition, bandStiffness, bandClearance, gravity);
+        releaseT = t;
+        outcome = predict(launch, t);
         state = State::Launching;
         return;
     }
 }
 
-void Scene::onMouseMoved(simd::float2 c) {
+void move(simd::float2 c) {
     if(state == State::Dragging) {
         missile.position = c + grabOffset;
+        previousMissile = missile.position;
     }
 }
 
+void Scene::onMouseClicked(Engine::Input::MouseButton button,
+                           Engine::Input::ButtonState buttonState,
+                           simd::float2 c) {
+    input.push(Engine::Input::Event{
+        .type=Engine::Input::Event::Type::MouseClick,
+        .position=c,
+        .button=button,
+        .state=buttonState
+    });
+}
+
+void Scene::onMouseMoved(simd::float2 c) {
+    input.push(Engine::Input::Event{.type=Engine::Input::Event::Type::MouseMove, .position=c});
+}
+
 bool Scene::onKey(Engine::Input::KeyboardButton, Engine::Input::ButtonState) {
     return false;
 }
 
-void Scene::onIdle(CFTimeInterval endT) {
-    auto t = startT;
-    for(; t < endT; t += dt) {
-        if (state != State::Hit) {
-            target.position = simd::float2{525,300} + simd::float2{0.0f, sinf(2.0f * M_PI * t * 0.5f) * 210};
+// Advances the birds to t, the end of a step.
+void step(Engine::Ticks t) {
+    snap();
+    if (state == State::Launching || state == State::Air) {
+        const float flightT = (float)Engine::seconds(t - releaseT);
+        if (flightT < outcome.end) {
+            state = launch.inBand(flightT) ? State::Launching : State::Air;
+            missile.position = launch.position(flightT);
+        } else if (outcome.hit) {
+            state = State::Hit;
+            missile.position = launch.position(outcome.end);
+            missile.color = simd::float3{1.0f,1.0f,0.0f};
+            // Stays where it was hit.
+            target.position = hover.position(Engine::seconds(releaseT) + outcome.end);
+            // The impact is found to within a tolerance on either side of
+            // touching; back the missile out along the contact normal so
+            // that the two rest against each other.
+            const auto contact = Collision::contact(missile.body(), target.body());
+            missile.position += contact.normal * contact.depth;
+        } else {
+            state = State::Idle;
+            missile = Bird{launchPosition, simd::float3{0.5f,0,0}, Facing::UpsideDown};
+            previousMissile = missile.position;
         }
-        
- 
-        if(state == State::Launching){
-            missile.position += launchVelocity;
-            if(simd::distance(missile.position, launchPosition) < 20.0f){
-                state = State::Air;
-                launchT = t;
-                velocity = launchVelocity;
-            }
-        }
- 
-        if(state == State::Air){
-            missile.position += velocity;
-            velocity = velocity + gravity * dt;
-
-            if(missile.intersect(target)) {
-                state = State::Hit;
-                missile.color = simd::float3{1.0f,1.0f,0.0f};
-                break;
-            }
-            if(missile.position.x > 660 || missile.position.x <= -60 || missile.position.y < -120 ) {
-                state = State::Idle;
-                missile = Bird{launchPosition, simd::float3{0.5f,0,0}, Facing::UpsideDown};
-                break;
-            }
+    }
+    if (state != State::Hit) {
+        target.position = hover.position(Engine::seconds(t));
+    }
+}
+
+void Scene::onIdle(const Engine::FrameContext& frame) {
+    // Input takes effect at the time simulated so far, before this frame's steps.
+    input.drain([](const Engine::Input::Event& event) {
+        if (event.type == Engine::Input::Event::Type::MouseClick) {
+            click(event.button, event.state, event.position, fixed.time());
+        } else if (event.type == Engine::Input::Event::Type::MouseMove) {
+            move(event.position);
         }
+    });
+    
+    fixed.advance(frame.delta, [](Engine::Ticks t) {
+        step(t + fixed.step());
+    });
+    publish(fixed.time());
+}
+
+// Band from the slingshot's fork to the missile, written straight into the
+// command list's arena.
+void drawRubber(Engine::CommandList& commands, simd::float2 center, simd::float2 low, simd::float2 high) {
+    const auto vertices = commands.allocate<simd::float2>(6);
+    if (vertices.empty()) {
+        return;
     }
-    startT = t;
+    vertices[0] = low;
+    vertices[1] = center + scaleToViewport(simd::float2{-0.1f, 0.04f});
+    vertices[2] = center + scaleToViewport(simd::float2{-0.1f, -0.04f});
+    vertices[3] = low;
+    vertices[4] = high;
+    vertices[5] = vertices[1];
+    drawPrimitive(commands, vertices, Colors::black, Engine::PrimitiveType::Triangle);
 }
 
-void Scene::onDraw(MTL::RenderCommandEncoder* enc) {
+void Scene::onDraw(Engine::CommandList& commands) {
+    // Shadows the simulation state, which belongs to the other thread. The
+    // birds are drawn between their last two steps.
+    const auto& snapshot = snapshots.read();
+    const auto state = snapshot.state;
+    const auto& preview = snapshot.preview;
+    const auto previewEnd = snapshot.previewEnd;
+    auto target = snapshot.target;
+    auto missile = snapshot.missile;
+    target.position = snapshot.previousTarget + (target.position - snapshot.previousTarget) * snapshot.alpha;
+    missile.position = snapshot.previousMissile + (missile.position - snapshot.previousMissile) * snapshot.alpha;
+    
     simd::float2 center(launchPosition);
     if ( state == State::Idle || state == State::Dragging || state == State::Launching ) {
         center=missile.position;
     }
     
-    enc->setVertexBytes(&viewport, sizeof(viewport), (NS::UInteger)VertexInputIndex::ViewportSize);
+    commands.bytes((uint8_t)VertexInputIndex::ViewportSize, viewport);
     
-    drawPrimitive(enc, skyVertices, skyColor);
-    drawPrimitive(enc, grassVertices, grassColor);
-    drawPrimitive(enc, slingshotBackVertices, slingshotColor);
+    drawPrimitive(commands, skyVertices, skyColor);
+    drawPrimitive(commands, grassVertices, grassColor);
+    drawPrimitive(commands, slingshotBackVertices, slingshotColor);
     
     // rubber back
-    drawPrimitive(enc, std::array<simd::float2, 6> {
-        scaleToViewport(simd::float2{-0.27f,-0.333f} + 1),
-        center + scaleToViewport(simd::float2{-0.1f, 0.04f}),
-        center + scaleToViewport(simd::float2{-0.1f, -0.04f}),
-        scaleToViewport(simd::float2{-0.27f,-0.333f} + 1),
-        scaleToViewport(simd::float2{-0.27f,-0.300f} + 1),
-        center + scaleToViewport(simd::float2{-0.1f, 0.04f})
-    }, Colors::black, MTL::PrimitiveType::PrimitiveTypeTriangle);
+    drawRubber(commands, center, scaleToViewport(simd::float2{-0.27f,-0.333f} + 1), scaleToViewport(simd::float2{-0.27f,-0.300f} + 1));
     
     
-    missile.draw(enc);
-    target.draw(enc);
+    auto& [missileShapes, targetShapes] = layers;
+    missileShapes.clear();
+    targetShapes.clear();
+    if (state == State::Dragging) {
+        for (int i = 1; i <= maxPreviewDots && i * previewInterval < previewEnd; ++i) {
+            missileShapes.circle(preview.position(i * previewInterval), 3, Colors::white);
+        }
+    }
+    missile.draw(missileShapes);
+    target.draw(targetShapes);
+    for (const auto& layer : layers) {
+        Shapes::draw(commands, layer, Shapes::Pipelines{Pipeline::Ellipses, Pipeline::Triangles});
+    }
     
-    drawPrimitive(enc, slingshotFrontVertices, slingshotColor);
+    drawPrimitive(commands, slingshotFrontVertices, slingshotColor);
     
     // rubber front
-    drawPrimitive(enc, std::array<simd::float2, 6> {
-        scaleToViewport(simd::float2{-0.333f,-0.333f} + 1),
-        center + scaleToViewport(simd::float2{-0.1f, 0.04f}),
-        center + scaleToViewport(simd::float2{-0.1f, -0.04f}),
-        scaleToViewport(simd::float2{-0.333f,-0.333f} + 1),
-        scaleToViewport(simd::float2{-0.333f,-0.300f} + 1),
-        center + scaleToViewport(simd::float2{-0.1f, 0.04f})
-    }, Colors::black, MTL::PrimitiveType::PrimitiveTypeTriangle);
-}
-
-Engine::Renderer* Scene::createRenderer(MTK::View* mtkView) {
-    return new Renderer(mtkView, *this);
+    drawRubber(commands, center, scaleToViewport(simd::float2{-0.333f,-0.333f} + 1), scaleToViewport(simd::float2{-0.333f,-0.300f} + 1));
 }
 
 } /* namespace S13E01 */
@@ -1,12 +1,15 @@
 #pragma once
 
+#include "../../Utility/ShapeTypes.hh"
+
 namespace Scenes {
 namespace S13E01 {
 
 enum class VertexInputIndex {
     Vertices,
     ViewportSize,
-    Color
+    Color,
+    Instances
 };
 
 } /* namespace S1301 */
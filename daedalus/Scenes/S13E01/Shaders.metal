@@ -50,6 +50,44 @@ namespace Scenes {
             return out;
         }
         
+        // Pixel space to clip space, as in vertexShader.
+        float4 pixelToClip(float2 pixelSpacePosition, vector_float2 viewportSize)
+        {
+            vector_float2 halfViewportSize = viewportSize / 2.0;
+            return float4((pixelSpacePosition - halfViewportSize) / halfViewportSize, 0.0, 1.0);
+        }
+        
+        // One instance of the unit circle mesh per ellipse of the shape layer.
+        vertex RasterizerData
+        ellipseVertexShader(uint vertexID [[vertex_id]],
+                            uint instanceID [[instance_id]],
+                            constant vector_float2 *vertices [[buffer(VertexInputIndex::Vertices)]],
+                            constant vector_float2 *viewportSize [[buffer(VertexInputIndex::ViewportSize)]],
+                            constant Shapes::EllipseInstance *instances [[buffer(VertexInputIndex::Instances)]])
+        {
+            constant Shapes::EllipseInstance& instance = instances[instanceID];
+            
+            RasterizerData out;
+            out.position = pixelToClip(instance.center + vertices[vertexID] * instance.radii * instance.facing, *viewportSize);
+            out.color = vector_float4(instance.color, 0);
+            return out;
+        }
+        
+        // Three vertices per triangle of the shape layer.
+        vertex RasterizerData
+        triangleVertexShader(uint vertexID [[vertex_id]],
+                             uint instanceID [[instance_id]],
+                             constant vector_float2 *viewportSize [[buffer(VertexInputIndex::ViewportSize)]],
+                             constant Shapes::TriangleInstance *instances [[buffer(VertexInputIndex::Instances)]])
+        {
+            constant Shapes::TriangleInstance& instance = instances[instanceID];
+            
+            RasterizerData out;
+            out.position = pixelToClip(instance.corners[vertexID], *viewportSize);
+            out.color = vector_float4(instance.color, 0);
+            return out;
+        }
+        
         fragment float4 fragmentShader(RasterizerData in [[stage_in]])
         {
             // Return the interpolated color.
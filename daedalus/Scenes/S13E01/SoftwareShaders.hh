@@ -0,0 +1,77 @@
+#pragma once
+
+#include <simd/simd.h>
+
+#include "../../Engine/SoftwareRenderer.hh"
+#include "ShaderTypes.hh"
+#include "Pipelines.hh"
+
+// C++ counterparts of Shaders.metal for the software rasterizer.
+namespace Scenes {
+namespace S13E01 {
+namespace Software {
+
+using Engine::Software::Buffers;
+using Engine::Software::VertexOut;
+
+// Pixel space to clip space, as in vertexShader.
+inline simd::float4 pixelToClip(const simd::float2& pixelSpacePosition, const simd::float2& viewportSize) {
+    const simd::float2 halfViewportSize = viewportSize / 2.0f;
+    const simd::float2 position = (pixelSpacePosition - halfViewportSize) / halfViewportSize;
+    return simd::float4{position.x, position.y, 0.0f, 1.0f};
+}
+
+inline VertexOut vertexShader(const Buffers& buffers, uint32_t vertexID, uint32_t) {
+    const auto vertices = buffers.get<simd::float2>(VertexInputIndex::Vertices);
+    const auto viewportSize = buffers.get<simd::float2>(VertexInputIndex::ViewportSize);
+    const auto color = buffers.get<simd::float3>(VertexInputIndex::Color);
+
+    return VertexOut{
+        pixelToClip(vertices[vertexID], *viewportSize),
+        simd::float4{color->x, color->y, color->z, 0},
+    };
+}
+
+inline VertexOut ellipseVertexShader(const Buffers& buffers, uint32_t vertexID, uint32_t instanceID) {
+    const auto vertices = buffers.get<simd::float2>(VertexInputIndex::Vertices);
+    const auto viewportSize = buffers.get<simd::float2>(VertexInputIndex::ViewportSize);
+    const auto& instance = buffers.get<Shapes::EllipseInstance>(VertexInputIndex::Instances)[instanceID];
+
+    return VertexOut{
+        pixelToClip(instance.center + vertices[vertexID] * instance.radii * instance.facing, *viewportSize),
+        simd::float4{instance.color.x, instance.color.y, instance.color.z, 0},
+    };
+}
+
+inline VertexOut triangleVertexShader(const Buffers& buffers, uint32_t vertexID, uint32_t instanceID) {
+    const auto viewportSize = buffers.get<simd::float2>(VertexInputIndex::ViewportSize);
+    const auto& instance = buffers.get<Shapes::TriangleInstance>(VertexInputIndex::Instances)[instanceID];
+
+    return VertexOut{
+        pixelToClip(instance.corners[vertexID], *viewportSize),
+        simd::float4{instance.color.x, instance.color.y, instance.color.z, 0},
+    };
+}
+
+inline const Engine::Software::Program& program() {
+    static_assert(Pipeline::Primitives == 0 && Pipeline::Ellipses == 1 && Pipeline::Triangles == 2);
+    static const Engine::Software::VertexShader pipelines[Pipeline::Count] = {
+        vertexShader,
+        ellipseVertexShader,
+        triangleVertexShader,
+    };
+    static const Engine::Software::Program program{
+        pipelines,
+        Engine::Bindings{
+            .vertices=(uint8_t)VertexInputIndex::Vertices,
+            .color=(uint8_t)VertexInputIndex::Color,
+            .instances=(uint8_t)VertexInputIndex::Instances
+        },
+        ClearColor,
+    };
+    return program;
+}
+
+} /* namespace Software */
+} /* namespace S13E01 */
+} /* namespace Scenes */
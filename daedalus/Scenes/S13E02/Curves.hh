@@ -0,0 +1,1013 @@
+#pragma once
+
+#include <simd/simd.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <span>
+
+#include "../../Engine/Trace.hh"
+#include "../../Utility/SmallVector.hh"
+
+namespace Scenes {
+namespace S13E02 {
+
+// Integrates f over [a, b] by five-point Gauss-Legendre quadrature, exact
+// for polynomials up to degree nine.
+template <class F>
+float integrate(const F& f, float a, float b) {
+    constexpr float x[5] = {0.0f, -0.5384693101056831f, 0.5384693101056831f, -0.9061798459386640f, 0.9061798459386640f};
+    constexpr float w[5] = {0.5688888888888889f, 0.4786286704993665f, 0.4786286704993665f, 0.2369268850561891f, 0.2369268850561891f};
+    const float c = 0.5f * (a + b);
+    const float h = 0.5f * (b - a);
+    float sum = 0;
+    for (auto i = 0; i < 5; ++i) {
+        sum += w[i] * f(c + h * x[i]);
+    }
+    return sum * h;
+}
+
+// Cumulative arc length sampled at the knots of a curve's parameter range.
+// Interval i spans [knots[i], knots[i+1]] and lengths[i] is the arc length up
+// to knots[i]. Lookups in both directions binary search the knots and then
+// integrate the curve's speed within a single interval; speed(i, t) must
+// return |dr/dt| at a parameter t inside interval i.
+template <size_t Inline>
+struct ArcLengthTable {
+    Utility::SmallVector<float, Inline> knots;
+    Utility::SmallVector<float, Inline> lengths;
+    
+    int size() const {
+        return (int)knots.size();
+    }
+    
+    float total() const {
+        return lengths.empty() ? 0 : lengths.back();
+    }
+    
+    // Recomputes the cumulative lengths from knot i onwards, after the
+    // caller has set the knots.
+    template <class Speed>
+    void accumulate(int i, const Speed& speed) {
+        const int count = size();
+        lengths.resize(count);
+        if (count > 0 && i <= 0) {
+            lengths[0] = 0;
+            i = 1;
+        }
+        for (auto j = i; j < count; ++j) {
+            lengths[j] = lengths[j-1] + integrate([&](float t) { return speed(j - 1, t); }, knots[j-1], knots[j]);
+        }
+    }
+    
+    // Arc length from the start of the curve to parameter t.
+    template <class Speed>
+    float lengthAt(float t, const Speed& speed) const {
+        const int count = size();
+        if (count < 2 || t <= knots[0]) {
+            return 0;
+        }
+        if (t >= knots[count-1]) {
+            return total();
+        }
+        const int i = std::clamp(int(std::upper_bound(knots.begin(), knots.end(), t) - knots.begin()) - 1, 0, count - 2);
+        return lengths[i] + integrate([&](float x) { return speed(i, x); }, knots[i], t);
+    }
+    
+    // Parameter at which the arc length from the start reaches s. Newton's
+    // method inside the interval, falling back to bisection whenever a step
+    // would leave the bracket.
+    template <class Speed>
+    float parameterAt(float s, const Speed& speed) const {
+        const int count = size();
+        if (count == 0) {
+            return 0;
+        }
+        if (count == 1 || s <= 0) {
+            return knots[0];
+        }
+        if (s >= total()) {
+            return knots[count-1];
+        }
+        const int i = std::clamp(int(std::upper_bound(lengths.begin(), lengths.end(), s) - lengths.begin()) - 1, 0, count - 2);
+        const float target = s - lengths[i];
+        const float span = lengths[i+1] - lengths[i];
+        float lo = knots[i], hi = knots[i+1];
+        float x = span > 0 ? lo + (hi - lo) * (target / span) : lo;
+        for (auto k = 0; k < 8; ++k) {
+            const float error = integrate([&](float y) { return speed(i, y); }, knots[i], x) - target;
+            if (fabsf(error) <= 1e-5f * std::max(span, 1.0f)) {
+                break;
+            }
+            (error > 0 ? hi : lo) = x;
+            const float v = speed(i, x);
+            const float next = v > 0 ? x - error / v : lo;
+            x = next > lo && next < hi ? next : 0.5f * (lo + hi);
+        }
+        return x;
+    }
+};
+
+struct TCR {
+    // Cubic Hermite polynomial of one segment in power form, parameterized by
+    // the time elapsed since the start of the segment. Segments are stored
+    // with V = float2; weight() runs the same polynomial on float4 lanes.
+    template <class V>
+    struct Cubic {
+        V a0, a1, a2, a3;
+        
+        static constexpr Cubic make(
+                                    std::array<V, 2> p,
+                                    std::array<V, 2> v,
+                                    std::array<float, 2> t
+                                    ) {
+            const float tau = t[1] - t[0];
+            const float tauInv = 1.0f / tau;
+            const V eps = (p[1] - p[0]) * tauInv;
+            
+            return Cubic{
+                .a0 = p[0],
+                .a1 = v[0],
+                .a2 = (eps * 3.0f - (v[1] + v[0] * 2.0f)) * tauInv,
+                .a3 = (eps * -2.0f + (v[1] + v[0])) * (tauInv * tauInv),
+            };
+        }
+        
+        constexpr V operator()(float dt) const {
+            return ((a3 * dt + a2) * dt + a1) * dt + a0;
+        }
+        
+        constexpr V derivative(float dt) const {
+            return (a3 * (3.0f * dt) + a2 * 2.0f) * dt + a1;
+        }
+        
+        // Samples the segment at dt0, dt0 + h, ... into out by forward
+        // differencing. Four consecutive samples are kept in the lanes of one
+        // vector per coordinate and advanced together with stride 4h, so a
+        // group of four costs three vector adds per coordinate. The differences
+        // are reseeded analytically every Reseed samples to bound float drift.
+        void tessellate(float dt0, float h, std::span<simd::float2> out) const {
+            constexpr size_t Reseed = 64;
+            const simd::float4 lanes{0.0f, 1.0f, 2.0f, 3.0f};
+            const float H = 4.0f * h;
+            
+            for (size_t i0 = 0; i0 < out.size(); i0 += Reseed) {
+                const simd::float4 s = dt0 + (float)i0 * h + lanes * h;
+                
+                simd::float4 f[2], d1[2], d2[2];
+                float d3[2];
+                for (int c = 0; c < 2; ++c) {
+                    const float b0 = a0[c], b1 = a1[c], b2 = a2[c], b3 = a3[c];
+                    f[c] = ((b3 * s + b2) * s + b1) * s + b0;
+                    d1[c] = b1 * H + b2 * (2.0f * s * H + H * H) + b3 * (3.0f * s * s * H + 3.0f * s * H * H + H * H * H);
+                    d2[c] = 2.0f * b2 * H * H + b3 * (6.0f * s * H * H + 6.0f * H * H * H);
+                    d3[c] = 6.0f * b3 * H * H * H;
+                }
+                
+                const size_t end = std::min(i0 + Reseed, out.size());
+                for (size_t i = i0; i < end; i += 4) {
+                    for (size_t k = 0; k < 4 && i + k < end; ++k) {
+                        out[i + k] = {f[0][k], f[1][k]};
+                    }
+                    for (int c = 0; c < 2; ++c) {
+                        f[c] += d1[c];
+                        d1[c] += d2[c];
+                        d2[c] += d3[c];
+                    }
+                }
+            }
+        }
+    };
+    
+    static constexpr simd::float4 tcr(
+                                      std::array<simd::float4, 2> p,
+                                      std::array<simd::float4, 2> v,
+                                      std::array<float, 2> t,
+                                      float tx
+                                      ) {
+        return Cubic<simd::float4>::make(p, v, t)(tx - t[0]);
+    }
+    using Segment = Cubic<simd::float2>;
+    static constexpr float tension = -0.5f;
+    // Points kept in place before the storage moves to the heap.
+    static constexpr size_t N = 10;
+    
+    // Control points as structure of arrays: parameter t[i] at (x[i], y[i]).
+    Utility::SmallVector<float, N> t, x, y;
+    Utility::SmallVector<simd::float2, N> v;
+    // segments[i] interpolates between points i and i+1.
+    Utility::SmallVector<Segment, N> segments;
+    // Bumped by every edit; segmentRevisions[i] is the revision that last
+    // changed segments[i]. Lets caches find the segments they hold stale.
+    uint64_t revision = 0;
+    Utility::SmallVector<uint64_t, N> segmentRevisions;
+    // Gauss-Legendre over a whole segment is too coarse near sharp turns, so
+    // each segment is split into this many intervals of the arc length table.
+    static constexpr int ArcLengthSubdivisions = 4;
+    ArcLengthTable<(N - 1) * ArcLengthSubdivisions + 1> arcLength;
+    
+    int size() const {
+        return (int)t.size();
+    }
+    
+    simd::float2 point(int i) const {
+        return simd::float2{x[i], y[i]};
+    }
+    
+    // Index of the segment containing t, clamped to the valid segments.
+    int index(float t) const {
+        auto i = int(std::upper_bound(this->t.begin(), this->t.end(), t) - this->t.begin()) - 1;
+        return std::clamp(i, 0, std::max(size() - 2, 0));
+    }
+    
+    // Segment lookup for monotonically increasing parameters, as when the
+    // animation moves along the curve frame by frame. Advances segment by
+    // segment from where the last lookup ended instead of searching, so a
+    // sweep costs O(lookups + points). Falls back to index() when the
+    // parameter goes backwards, e.g. when the animation loops. Holds no
+    // reference to the curve, so it can outlive the copy it was used with.
+    struct Cursor {
+        int i = 0;
+        
+        int seek(const TCR& curve, float tx) {
+            if (i > curve.size() - 2 || tx < curve.t[i]) {
+                return i = curve.index(tx);
+            }
+            while (i + 2 < curve.size() && curve.t[i+1] <= tx) {
+                ++i;
+            }
+            return i;
+        }
+    };
+    
+    // Amortized O(1): only the last two segments and their arc lengths change.
+    void addControlPoint(const simd::float2& px, float tx) {
+        t.push_back(tx);
+        x.push_back(px.x);
+        y.push_back(px.y);
+        v.push_back({});
+        ++revision;
+        const int count = size();
+        if(count > 2) {
+            v[count-2] = velocity(count-2);
+        }
+        
+        // The new point adds a segment and changes the end velocity of the previous one.
+        segments.resize(std::max(count - 1, 0));
+        segmentRevisions.resize(std::max(count - 1, 0));
+        for (auto i = std::max(count - 3, 0); i < count - 1; ++i) {
+            updateSegment(i);
+        }
+        updateArcLength(std::max(count - 3, 0));
+        
+        return;
+    }
+    
+    void updateSegment(int i) {
+        segments[i] = Segment::make(
+                                    std::array<simd::float2, 2>{point(i), point(i+1)},
+                                    std::array<simd::float2, 2>{v[i], v[i+1]},
+                                    std::array<float, 2>{t[i], t[i+1]}
+                                    );
+        segmentRevisions[i] = revision;
+    }
+    
+    // Speed |dr/dt| inside interval j of the arc length table.
+    float speed(int j, float tx) const {
+        const int i = j / ArcLengthSubdivisions;
+        return simd::length(segments[i].derivative(tx - t[i]));
+    }
+    
+    // Recomputes the arc length table from segment i onwards.
+    void updateArcLength(int i) {
+        constexpr int K = ArcLengthSubdivisions;
+        const int count = size();
+        auto& table = arcLength;
+        table.knots.resize(count > 1 ? (count - 1) * K + 1 : count);
+        for (auto j = i * K; j < table.size() - 1; ++j) {
+            const int s = j / K;
+            table.knots[j] = t[s] + (t[s+1] - t[s]) * (float)(j - s * K) / K;
+        }
+        table.knots.back() = t[count-1];
+        table.accumulate(i * K, [this](int j, float tx) { return speed(j, tx); });
+    }
+    
+    float length() const {
+        return arcLength.total();
+    }
+    
+    // Arc length of the curve between t[0] and tx.
+    float lengthAt(float tx) const {
+        return arcLength.lengthAt(tx, [this](int j, float x) { return speed(j, x); });
+    }
+    
+    // Parameter at arc length s from the start; advancing s uniformly in time
+    // traverses the curve at constant speed.
+    float parameterAt(float s) const {
+        return arcLength.parameterAt(s, [this](int j, float x) { return speed(j, x); });
+    }
+    
+    simd::float2 velocity(int i) const {
+        if (i < 0 || i >= size() - 1) {
+            return {};
+        }
+        
+        simd::float2 v{};
+        for (auto j = i; j <= i+1; ++j) {
+            v = (point(i) - point(i-1)) / (t[i] - t[i-1]);
+        }
+        
+        return v * ((1.0f - tension) / 2.0f);
+    }
+    
+    simd::float4 weight(float tx) const {
+        return weight(tx, index(tx));
+    }
+    
+    // Weights at tx, which lies in segment i as found by index() or a Cursor.
+    simd::float4 weight(float tx, int i) const {
+        const int count = size();
+        if (count == 0) {
+            return {};
+        }
+        
+        simd::float4 p_[4]{
+            {1,},
+            {0,1},
+            {0,0,1},
+            {0,0,0,1}
+        };
+        
+        if (count == 1 || tx <= t[0]) {
+            return p_[1];
+        }
+        
+        if (tx >= t[count-1]) {
+            return p_[2];
+        }
+        
+        auto v_ = std::array<simd::float4, 2>{};
+        for (auto j = i; j < i+2; ++j) {
+            v_[j-i] = (i-1 < 0 || i+1 > count) ? simd::float4{} :
+            ((p_[j-i+1] - p_[j-i])/(t[i] - t[i-1]) + (p_[j-i+2] - p_[j-i+1])/(t[i+1] - t[i])) *
+            ((1.0f - tension) / 2.0f);
+        }
+        
+        return tcr(
+                   std::array<simd::float4, 2>{p_[1], p_[2]},
+                   v_,
+                   std::array<float, 2>{t[i+1], t[i]},
+                   tx
+                   );
+    }
+    
+    simd::float2 operator()(float tx) const {
+        return (*this)(tx, index(tx));
+    }
+    
+    // The point at tx, which lies in segment i as found by index() or a Cursor.
+    simd::float2 operator()(float tx, int i) const {
+        const int count = size();
+        if (count == 0) {
+            return {};
+        }
+        
+        if (count == 1 || tx <= t[0]) {
+            return point(0);
+        }
+        
+        if (tx >= t[count-1]) {
+            return point(count-1);
+        }
+        
+        return segments[i](tx - t[i]);
+    }
+    
+    // Flattens the curve into a line strip, splitting each segment until every
+    // piece's midpoint lies within tolerance of its chord. Distances are
+    // measured after applying the linear part of toScreen, so a world-to-pixels
+    // transform gives a tolerance in pixels. Returns the number of vertices
+    // written. When out runs short, pending pieces are emitted unsplit, so the
+    // strip still spans the whole curve as long as out holds the control points.
+    size_t tessellateAdaptive(std::span<simd::float2> out, float tolerance, const simd::float4x4& toScreen) const {
+        const int count = size();
+        if (count == 0 || out.empty()) {
+            return 0;
+        }
+        
+        size_t n = 0;
+        out[n++] = point(0);
+        for (auto i = 0; i < count - 1 && n < out.size(); ++i) {
+            n = tessellateAdaptive(i, out, n, count - 2 - i, tolerance, toScreen);
+        }
+        return n;
+    }
+    
+    // Vertices segment i can produce at most, excluding its start point.
+    static constexpr size_t MaxSegmentVertices = 1 << 12;
+    
+    // Flattens segment i into out[n...], after its start point in out[n-1].
+    // Leaves room for at least one vertex for each of the reserved segments
+    // that follow. Returns the new vertex count.
+    size_t tessellateAdaptive(int i, std::span<simd::float2> out, size_t n, size_t reserved, float tolerance, const simd::float4x4& toScreen) const {
+        // Always split a little: the midpoint of an S-shaped piece can sit on its chord.
+        constexpr int MinDepth = 2;
+        constexpr int MaxDepth = 12;
+        static_assert(MaxSegmentVertices == 1 << MaxDepth);
+        
+        struct Piece {
+            float a, b;
+            int depth;
+        };
+        
+        const simd::float2 sx = toScreen.columns[0].xy;
+        const simd::float2 sy = toScreen.columns[1].xy;
+        auto screen = [&](simd::float2 v) { return sx * v.x + sy * v.y; };
+        
+        const auto& segment = segments[i];
+        const float tau = t[i+1] - t[i];
+        
+        Piece stack[MaxDepth + 1];
+        int top = 0;
+        stack[top++] = Piece{0, tau, 0};
+        
+        while (top > 0 && n < out.size()) {
+            const Piece piece = stack[--top];
+            const float m = 0.5f * (piece.a + piece.b);
+            const simd::float2 pb = piece.b == tau ? point(i+1) : segment(piece.b);
+            
+            // Splitting needs one more vertex than emitting; keep one per pending piece.
+            bool split = piece.depth < MaxDepth && n + top + reserved + 2 <= out.size();
+            if (split && piece.depth >= MinDepth) {
+                const simd::float2 chord = screen(pb - out[n-1]);
+                const simd::float2 offset = screen(segment(m) - out[n-1]);
+                const float len = simd::length(chord);
+                const float deviation = len > 0 ? fabsf(chord.x * offset.y - chord.y * offset.x) / len : simd::length(offset);
+                split = deviation > tolerance;
+            }
+            
+            if (split) {
+                stack[top++] = Piece{m, piece.b, piece.depth + 1};
+                stack[top++] = Piece{piece.a, m, piece.depth + 1};
+            } else {
+                out[n++] = pb;
+            }
+        }
+        
+        return n;
+    }
+};
+
+struct Bezier {
+    // Points kept in place before the storage moves to the heap. Up to N
+    // points the curve is evaluated through the binomial table and the power
+    // basis; past that those overflow or lose all precision, and evaluation
+    // switches to bernstein(), which only visits the non-negligible terms.
+    static constexpr size_t N = 10;
+    
+    // Control points as structure of arrays.
+    Utility::SmallVector<float, N> x, y;
+    // Row size() - 1 of Pascal's triangle, the Bernstein coefficients of the
+    // current degree. Only maintained while size() <= N.
+    float binomials[N];
+    // Bumped by every edit.
+    uint64_t revision = 0;
+    static constexpr int ArcLengthIntervals = 32;
+    ArcLengthTable<ArcLengthIntervals + 1> arcLength;
+    
+    int size() const {
+        return (int)x.size();
+    }
+    
+    simd::float2 point(int i) const {
+        return simd::float2{x[i], y[i]};
+    }
+    
+    void addControlPoint(const simd::float2& px) {
+        append(px);
+        updateArcLength();
+    }
+    
+    // Appends many points with a single arc length rebuild.
+    void addControlPoints(std::span<const simd::float2> px) {
+        for (const auto& q : px) {
+            append(q);
+        }
+        updateArcLength();
+    }
+    
+    void append(const simd::float2& px) {
+        ++revision;
+        const int count = size();
+        x.push_back(px.x);
+        y.push_back(px.y);
+        if (count < int(N)) {
+            binomials[count] = 1;
+            for (auto i = count - 1; i > 0; --i) {
+                binomials[i] += binomials[i-1];
+            }
+            binomials[0] = 1;
+        }
+    }
+    
+    // Calls f(i, b) with the Bernstein basis values b = B(i, degree, t) above
+    // Negligible. They are generated outwards from the largest one, which is
+    // found through lgamma, so neither the binomials nor the powers overflow
+    // and only O(sqrt(degree)) terms are visited.
+    template <class F>
+    static void bernstein(int degree, float t, const F& f) {
+        constexpr double Negligible = 1e-9;
+        if (degree == 0 || t <= 0) {
+            f(0, 1.0f);
+            return;
+        }
+        if (t >= 1) {
+            f(degree, 1.0f);
+            return;
+        }
+        const double n = degree;
+        const double ratio = t / (1.0 - t);
+        const int m = std::clamp((int)std::lround(n * t), 0, degree);
+        const double peak = std::exp(std::lgamma(n + 1) - std::lgamma(m + 1.0) - std::lgamma(n - m + 1) +
+                                     m * std::log((double)t) + (n - m) * std::log1p(-(double)t));
+        f(m, (float)peak);
+        double b = peak;
+        for (auto i = m + 1; i <= degree; ++i) {
+            b *= (n - i + 1) / i * ratio;
+            if (b < Negligible) {
+                break;
+            }
+            f(i, (float)b);
+        }
+        b = peak;
+        for (auto i = m - 1; i >= 0; --i) {
+            b *= (i + 1) / (n - i) / ratio;
+            if (b < Negligible) {
+                break;
+            }
+            f(i, (float)b);
+        }
+    }
+    
+    // Tangent dr/dt: the degree times the Bezier curve of the control point
+    // differences, one degree lower.
+    simd::float2 derivative(float t) const {
+        const int count = size();
+        if (count < 2) {
+            return {};
+        }
+        simd::float2 result{};
+        bernstein(count - 2, t, [&](int i, float b) {
+            result += (point(i + 1) - point(i)) * b;
+        });
+        return result * (float)(count - 1);
+    }
+    
+    // Every control point reshapes the whole curve, so the arc length table
+    // is rebuilt over evenly spaced parameters on each append.
+    void updateArcLength() {
+        const int count = size();
+        arcLength.knots.resize(count > 1 ? ArcLengthIntervals + 1 : count);
+        for (auto j = 0; j < arcLength.size(); ++j) {
+            arcLength.knots[j] = (float)j / ArcLengthIntervals;
+        }
+        arcLength.accumulate(0, [this](int, float t) { return simd::length(derivative(t)); });
+    }
+    
+    float length() const {
+        return arcLength.total();
+    }
+    
+    // Arc length of the curve between 0 and t.
+    float lengthAt(float t) const {
+        return arcLength.lengthAt(t, [this](int, float x) { return simd::length(derivative(x)); });
+    }
+    
+    // Parameter at arc length s from the start.
+    float parameterAt(float s) const {
+        return arcLength.parameterAt(s, [this](int, float x) { return simd::length(derivative(x)); });
+    }
+    
+    static float ipow(float x, int n) {
+        float result = 1;
+        for (; n > 0; n >>= 1, x *= x) {
+            if (n & 1) {
+                result *= x;
+            }
+        }
+        return result;
+    }
+    
+    float weight(int i, float t) const {
+        const int d = size() - 1;
+        if (size() <= int(N)) {
+            return binomials[i] * ipow(t, i) * ipow(1 - t, d - i);
+        }
+        if (t <= 0 || t >= 1) {
+            return i == (t <= 0 ? 0 : d) ? 1 : 0;
+        }
+        return std::exp(std::lgamma(d + 1.0) - std::lgamma(i + 1.0) - std::lgamma(d - i + 1.0) +
+                        i * std::log(t) + (d - i) * std::log1p(-t));
+    }
+    
+    // Horner-like evaluation of the Bernstein form: one multiply-add per
+    // control point plus the running power of t.
+    simd::float2 operator()(float t) const {
+        const int count = size();
+        if(count == 0) {
+            return {};
+        }
+        if(count == 1 || t < 0 || t > 1) {
+            return point(0);
+        }
+        const int d = count - 1;
+        if (count > int(N)) {
+            simd::float2 result{};
+            bernstein(d, t, [&](int i, float b) {
+                result += point(i) * b;
+            });
+            return result;
+        }
+        const float u = 1 - t;
+        float tn = 1;
+        simd::float2 result = point(0) * u;
+        for (auto i = 1; i < d; ++i) {
+            tn *= t;
+            result = (result + point(i) * (binomials[i] * tn)) * u;
+        }
+        return result + point(d) * (tn * t);
+    }
+    
+    // Evaluates the curve at many parameters in [0, 1] as a product of the
+    // (parameters x control points) Bernstein basis matrix with the control
+    // points. Four parameters are processed at a time, one per SIMD lane.
+    void evaluate(std::span<const float> ts, std::span<simd::float2> out) const {
+        const int count = size();
+        if (count == 0) {
+            return;
+        }
+        if (count > int(N)) {
+            for (size_t k = 0; k < ts.size(); ++k) {
+                out[k] = (*this)(ts[k]);
+            }
+            return;
+        }
+        const int d = count - 1;
+        for (size_t k = 0; k < ts.size(); k += 4) {
+            const size_t m = std::min<size_t>(4, ts.size() - k);
+            simd::float4 t{};
+            for (size_t l = 0; l < m; ++l) {
+                t[l] = ts[k + l];
+            }
+            const simd::float4 u = 1.0f - t;
+            
+            // (1 - t)^(d - i), built from the right.
+            simd::float4 upow[N];
+            upow[d] = simd::float4{1, 1, 1, 1};
+            for (auto i = d - 1; i >= 0; --i) {
+                upow[i] = upow[i+1] * u;
+            }
+            
+            simd::float4 rx{}, ry{};
+            simd::float4 tpow{1, 1, 1, 1};
+            for (auto i = 0; i <= d; ++i, tpow *= t) {
+                const simd::float4 basis = tpow * upow[i] * binomials[i];
+                rx += basis * x[i];
+                ry += basis * y[i];
+            }
+            
+            for (size_t l = 0; l < m; ++l) {
+                out[k + l] = simd::float2{rx[l], ry[l]};
+            }
+        }
+    }
+    
+    // Flattens the curve into a line strip by halving it with de Casteljau's
+    // algorithm until each piece's control polygon is within tolerance of its
+    // chord; the curve lies in the hull of its control polygon, so the strip is
+    // too. The chord is a segment, not a line: control points in line with it
+    // but beyond its ends, as at a cusp or where the curve doubles back, still
+    // count as deviating. Distances are measured after applying the linear part
+    // of toScreen.
+    // Returns the number of vertices written. When out runs short, pending
+    // pieces are emitted unsplit, so the strip always reaches the last point.
+    size_t flatten(std::span<simd::float2> out, float tolerance, const simd::float4x4& toScreen) const {
+        constexpr int MaxDepth = 16;
+        
+        struct Piece {
+            simd::float2 q[N];
+            int depth;
+        };
+        
+        const int count = size();
+        if (count == 0 || out.empty()) {
+            return 0;
+        }
+        // Every split costs O(size()^2), sample high degrees uniformly instead.
+        if (count > int(N)) {
+            tessellate(out);
+            return out.size();
+        }
+        
+        const int d = count - 1;
+        const simd::float2 sx = toScreen.columns[0].xy;
+        const simd::float2 sy = toScreen.columns[1].xy;
+        auto screen = [&](simd::float2 v) { return sx * v.x + sy * v.y; };
+        
+        auto flat = [&](const Piece& piece) {
+            const simd::float2 chord = screen(piece.q[d] - piece.q[0]);
+            const float len = simd::length(chord);
+            const simd::float2 direction = len > 0 ? chord / len : simd::float2{};
+            for (auto i = 1; i < d; ++i) {
+                const simd::float2 offset = screen(piece.q[i] - piece.q[0]);
+                const float along = std::clamp(simd::dot(offset, direction), 0.0f, len);
+                if (simd::length(offset - direction * along) > tolerance) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        
+        Piece stack[MaxDepth + 1];
+        int top = 0;
+        for (auto i = 0; i <= d; ++i) {
+            stack[0].q[i] = point(i);
+        }
+        stack[top++].depth = 0;
+        
+        size_t n = 0;
+        out[n++] = point(0);
+        
+        while (top > 0 && n < out.size()) {
+            Piece& piece = stack[top - 1];
+            
+            // Splitting needs one more vertex than emitting; keep one per pending piece.
+            if (piece.depth == MaxDepth || n + top + 1 > out.size() || flat(piece)) {
+                out[n++] = piece.q[d];
+                --top;
+                continue;
+            }
+            
+            // Replace the piece with its right half, then push the left half on top.
+            Piece& left = stack[top++];
+            left.depth = ++piece.depth;
+            left.q[0] = piece.q[0];
+            for (auto k = 1; k <= d; ++k) {
+                for (auto i = 0; i <= d - k; ++i) {
+                    piece.q[i] = (piece.q[i] + piece.q[i+1]) * 0.5f;
+                }
+                left.q[k] = piece.q[0];
+            }
+        }
+        
+        return n;
+    }
+    
+    // Samples the curve at t = i / n for i < n = out.size() by forward
+    // differencing: size() - 1 vector adds per sample, x and y advanced
+    // together. The difference table is derived analytically in double from
+    // the power basis form and reseeded every Reseed samples. (Differencing
+    // sampled values instead would bury the tiny high-order differences in
+    // rounding noise.)
+    void tessellate(std::span<simd::float2> out) const {
+        const int count = size();
+        if (count == 0) {
+            return;
+        }
+        if (count > int(N)) {
+            for (size_t i = 0; i < out.size(); ++i) {
+                out[i] = (*this)((float)i / out.size());
+            }
+            return;
+        }
+        
+        constexpr size_t Reseed = 64;
+        const int d = count - 1;
+        const double h = 1.0 / out.size();
+        
+        double cx[N], cy[N];
+        powerBasis(cx, cy);
+        
+        simd::float2 diff[N];
+        for (size_t i0 = 0; i0 < out.size(); i0 += Reseed) {
+            // Taylor shift to f(t0 + h * s), then scale the coefficients by h^k.
+            const double t0 = i0 * h;
+            double bx[N], by[N];
+            std::copy(cx, cx + count, bx);
+            std::copy(cy, cy + count, by);
+            for (auto i = 0; i < d; ++i) {
+                for (auto j = d - 1; j >= i; --j) {
+                    bx[j] += t0 * bx[j+1];
+                    by[j] += t0 * by[j+1];
+                }
+            }
+            double hk = 1;
+            for (auto k = 0; k <= d; ++k, hk *= h) {
+                bx[k] *= hk;
+                by[k] *= hk;
+            }
+            
+            // The j-th forward difference of s^k at s = 0 is the number of surjections k -> j.
+            for (auto j = 0; j <= d; ++j) {
+                double dx = 0, dy = 0;
+                for (auto k = j; k <= d; ++k) {
+                    dx += bx[k] * Surjections[k][j];
+                    dy += by[k] * Surjections[k][j];
+                }
+                diff[j] = simd::float2{(float)dx, (float)dy};
+            }
+            
+            const size_t end = std::min(i0 + Reseed, out.size());
+            for (size_t i = i0; i < end; ++i) {
+                out[i] = diff[0];
+                for (auto j = 0; j < d; ++j) {
+                    diff[j] += diff[j+1];
+                }
+            }
+        }
+    }
+    
+    // Coefficients of the curve in the monomial basis, c[k] * t^k.
+    void powerBasis(double cx[N], double cy[N]) const {
+        const int d = size() - 1;
+        for (auto k = 0; k <= d; ++k) {
+            double sx = 0, sy = 0;
+            double ki = 1; // binomial(k, i)
+            for (auto i = 0; i <= k; ++i) {
+                const double sign = (k - i) % 2 ? -1 : 1;
+                sx += sign * ki * x[i];
+                sy += sign * ki * y[i];
+                ki = ki * (k - i) / (i + 1);
+            }
+            cx[k] = binomials[k] * sx;
+            cy[k] = binomials[k] * sy;
+        }
+    }
+    
+    static constexpr auto Surjections = [] {
+        std::array<std::array<double, N>, N> s{};
+        s[0][0] = 1;
+        for (size_t k = 1; k < N; ++k) {
+            for (size_t j = 1; j <= k; ++j) {
+                s[k][j] = j * (s[k-1][j] + s[k-1][j-1]);
+            }
+        }
+        return s;
+    }();
+};
+
+enum class TessellationMode { Uniform, Adaptive };
+
+struct TessellationParams {
+    TessellationMode mode;
+    // Maximum chord deviation of adaptive tessellation, measured after toScreen.
+    float tolerance;
+    // Maps world coordinates to window pixels; only its linear part is used.
+    simd::float4x4 toScreen;
+    
+    // Equal when they give the same tessellation: uniform tessellation
+    // ignores the tolerance and the camera, so moving the camera keeps it.
+    bool operator==(const TessellationParams& other) const {
+        if (mode != other.mode) {
+            return false;
+        }
+        if (mode == TessellationMode::Uniform) {
+            return true;
+        }
+        auto same = [](simd::float4 a, simd::float4 b) {
+            return a.x == b.x && a.y == b.y;
+        };
+        return tolerance == other.tolerance &&
+            same(toScreen.columns[0], other.toScreen.columns[0]) &&
+            same(toScreen.columns[1], other.toScreen.columns[1]);
+    }
+};
+
+// Line strip of a curve, kept between frames and redone only where the curve
+// changed. vertices[0] is the first control point and segment i contributes
+// vertices [offsets[i], offsets[i+1]). A TCR append re-tessellates the last
+// two segments; a Bezier append reshapes the whole curve, which is cached as
+// a single segment.
+struct TessellationCache {
+    // Samples per TCR segment in uniform mode.
+    static constexpr size_t UniformSegmentSamples = 50;
+    // Samples of a Bezier curve in uniform mode, and its vertex budget in adaptive mode.
+    static constexpr size_t UniformBezierSamples = 500;
+    static constexpr size_t AdaptiveBezierBudget = 4096;
+    
+    struct Counters {
+        // Updates that found something to redo.
+        uint64_t updates;
+        // Segments tessellated in total, each Bezier rebuild counting as one.
+        uint64_t segments;
+    };
+    
+    Utility::SmallVector<simd::float2, 64> vertices;
+    Utility::SmallVector<uint32_t, TCR::N> offsets;
+    TessellationParams params;
+    // Curve revision the cache reflects, zero when empty.
+    uint64_t revision = 0;
+    Counters counters{};
+    
+    std::span<const simd::float2> strip() const {
+        return std::span(vertices.data(), vertices.size());
+    }
+    
+    void clear() {
+        vertices.clear();
+        offsets.clear();
+        revision = 0;
+    }
+    
+    std::span<const simd::float2> update(const TCR& curve, const TessellationParams& params) {
+        TRACE_ZONE("TessellationCache::update TCR");
+        if (!(params == this->params)) {
+            clear();
+            this->params = params;
+        }
+        if (curve.revision == revision) {
+            return strip();
+        }
+        
+        const int count = curve.size();
+        if (count == 0) {
+            clear();
+            return strip();
+        }
+        
+        // Keep the cached prefix up to the first segment changed since.
+        int first = std::min((int)offsets.size() - 1, count - 1);
+        while (first > 0 && curve.segmentRevisions[first - 1] > revision) {
+            --first;
+        }
+        if (first <= 0) {
+            vertices.clear();
+            vertices.push_back(curve.point(0));
+            offsets.clear();
+            offsets.push_back(1);
+            first = 0;
+        } else {
+            vertices.resize(offsets[first]);
+            offsets.resize(first + 1);
+        }
+        
+        for (auto i = first; i < count - 1; ++i) {
+            size_t n = vertices.size();
+            // Room for the worst case, written but not cleared first.
+            if (params.mode == TessellationMode::Adaptive) {
+                vertices.resize_for_overwrite(n + TCR::MaxSegmentVertices);
+                n = curve.tessellateAdaptive(i, std::span(vertices.data(), vertices.size()), n, 0, params.tolerance, params.toScreen);
+            } else {
+                constexpr size_t k = UniformSegmentSamples;
+                const float h = (curve.t[i+1] - curve.t[i]) / k;
+                vertices.resize_for_overwrite(n + k);
+                curve.segments[i].tessellate(h, h, std::span(vertices.data() + n, k - 1));
+                vertices[n + k - 1] = curve.point(i+1);
+                n += k;
+            }
+            vertices.resize(n);
+            offsets.push_back((uint32_t)n);
+        }
+        
+        counters.updates++;
+        counters.segments += count - 1 - first;
+        revision = curve.revision;
+        return strip();
+    }
+    
+    std::span<const simd::float2> update(const Bezier& curve, const TessellationParams& params) {
+        TRACE_ZONE("TessellationCache::update Bezier");
+        if (!(params == this->params)) {
+            clear();
+            this->params = params;
+        }
+        if (curve.revision == revision) {
+            return strip();
+        }
+        
+        size_t n = 0;
+        if (curve.size() > 0) {
+            if (params.mode == TessellationMode::Adaptive) {
+                vertices.resize_for_overwrite(AdaptiveBezierBudget);
+                n = curve.flatten(std::span(vertices.data(), vertices.size()), params.tolerance, params.toScreen);
+            } else {
+                n = UniformBezierSamples;
+                vertices.resize_for_overwrite(n);
+                curve.tessellate(std::span(vertices.data(), n));
+            }
+        }
+        vertices.resize(n);
+        offsets.clear();
+        offsets.push_back(n > 0 ? 1 : 0);
+        offsets.push_back((uint32_t)n);
+        
+        counters.updates++;
+        counters.segments++;
+        revision = curve.revision;
+        return strip();
+    }
+};
+
+} /* namespace S13E02 */
+} /* namespace Scenes */
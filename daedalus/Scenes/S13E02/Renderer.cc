@@ -3,8 +3,11 @@
 #include <simd/simd.h>
 
 #include "../../Engine/Engine.hh"
+#include "../../Engine/MetalReplay.hh"
+#include "../../Engine/Trace.hh"
 
-#include "./Scene.hh"
+#include "./Renderer.hh"
+#include "./ShaderTypes.hh"
 
 namespace Scenes {
 namespace S13E02 {
@@ -17,7 +20,7 @@ Renderer::Renderer(MTK::View* mtkView, Scene& scene)
     NS::Error* err = nullptr;
     
     mtkView->setColorPixelFormat( MTL::PixelFormat::PixelFormatBGRA8Unorm_sRGB );
-    mtkView->setClearColor( MTL::ClearColor::Make( 1.0, 1.0, 1.0, 1.0 ) );
+    mtkView->setClearColor( MTL::ClearColor::Make( ClearColor.x, ClearColor.y, ClearColor.z, ClearColor.w ) );
     
     // Load all the shader files with a .metal file extension in the project.
     auto library = ns_ptr(device->newDefaultLibrary());
@@ -43,12 +46,17 @@ Renderer::Renderer(MTK::View* mtkView, Scene& scene)
         assert( false );
     }
 
+    ellipseState = ns_ptr(Engine::makePipeline(device.get(), library.get(), "Scenes::S13E02::ellipseVertexShader", "Scenes::S13E02::fragmentShader", mtkView->colorPixelFormat()));
+    triangleState = ns_ptr(Engine::makePipeline(device.get(), library.get(), "Scenes::S13E02::triangleVertexShader", "Scenes::S13E02::fragmentShader", mtkView->colorPixelFormat()));
+    
     q = ns_ptr(device->newCommandQueue());
+    uploads = std::make_unique<Engine::MetalUploadRing>(device.get(), 1 << 20);
 }
 
 Renderer::~Renderer() {}
 
 void Renderer::drawInMTKView(MTK::View* view) {
+    TRACE_ZONE("Renderer::drawInMTKView");
     auto pool = NS::AutoreleasePool::alloc()->init();
     
     auto cmdBuffer = q->commandBuffer();
@@ -64,11 +72,25 @@ void Renderer::drawInMTKView(MTK::View* view) {
             .zfar=1.0
         });
         
-        enc->setRenderPipelineState(state.get());
+        {
+            TRACE_ZONE("Scene::onDraw");
+            commands.reset();
+            scene.onDraw(commands);
+        }
         
-        scene.onDraw(enc);
+        {
+            TRACE_ZONE("Engine::replay");
+            MTL::RenderPipelineState* const pipelines[Pipeline::Count] = {state.get(), ellipseState.get(), triangleState.get()};
+            Engine::replay(enc, commands, pipelines, Engine::Bindings{
+                .vertices=(uint8_t)VertexInputIndex::Vertices,
+                .color=(uint8_t)VertexInputIndex::Color,
+                .instances=(uint8_t)VertexInputIndex::Instances
+            }, uploads.get());
+        }
         
+        TRACE_ZONE("Renderer::commit");
         enc->endEncoding();
+        uploads->commit(cmdBuffer);
         cmdBuffer->presentDrawable(view->currentDrawable());
         cmdBuffer->commit();
     }
@@ -80,5 +102,9 @@ void Renderer::drawableSizeWillChange(MTK::View* view, CGSize size) {
     viewport.y = size.height;
 }
 
+Engine::Renderer* Scene::createRenderer(MTK::View* mtkView) {
+    return new Renderer(mtkView, *this);
+}
+
 } /* namespace S13E02 */
 } /* namespace Scenes */
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <MetalKit/MetalKit.hpp>
+#include <memory>
+#include "../../Utility/AppKitExt.hh"
+#include "../../Engine/Engine.hh"
+#include "../../Engine/CommandList.hh"
+#include "./Scene.hh"
+
+namespace Engine { class MetalUploadRing; }
+
+namespace Scenes {
+namespace S13E02 {
+
+struct Renderer : public Engine::Renderer {
+    Renderer(MTK::View* mtkView, Scene& scene);
+    virtual void drawInMTKView(MTK::View* view) override;
+    virtual void drawableSizeWillChange(MTK::View* view, CGSize size) override;
+    virtual ~Renderer() override;
+private:
+    NSExt::ns_ptr<MTL::Device> device;
+    NSExt::ns_ptr<MTL::CommandQueue> q;
+    NSExt::ns_ptr<MTL::RenderPipelineState> state;
+    NSExt::ns_ptr<MTL::RenderPipelineState> ellipseState;
+    NSExt::ns_ptr<MTL::RenderPipelineState> triangleState;
+    Engine::CommandList commands;
+    // Vertex data over the setVertexBytes limit.
+    std::unique_ptr<Engine::MetalUploadRing> uploads;
+    simd_uint2 viewport;
+    Scene& scene;
+};
+
+} /* namespace S13E02 */
+} /* namespace Scenes */
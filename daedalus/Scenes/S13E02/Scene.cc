@@ -1,8 +1,11 @@
 #include <simd/simd.h>
-#include <numbers>
+#include <memory>
+#include <span>
 
 #include "Scene.hh"
 #include "ShaderTypes.hh"
+#include "Curves.hh"
+#include "../../Engine/Handoff.hh"
 
 namespace Scenes {
 
@@ -48,52 +51,22 @@ constexpr simd::float3 yellow = {1.0f,1.0f,0.0f};
 
 } /* namespace colors */
 
-template <size_t N>
 INLINE
-void drawPrimitive(MTL::RenderCommandEncoder* enc,
-                   const std::array<simd::float2, N>& vertices,
+void drawPrimitive(Engine::CommandList& commands,
+                   std::span<const simd::float2> vertices,
                    const simd::float3& color,
-                   MTL::PrimitiveType primitiveType = MTL::PrimitiveType::PrimitiveTypeTriangleStrip
+                   Engine::PrimitiveType primitiveType = Engine::PrimitiveType::TriangleStrip
                    ) {
-    enc->setVertexBytes(vertices.data(), sizeof(vertices), (NS::UInteger)VertexInputIndex::Vertices);
-    enc->setVertexBytes(&color, sizeof(color), (NS::UInteger)VertexInputIndex::Color);
-    enc->drawPrimitives(primitiveType, NS::UInteger(0), NS::UInteger(vertices.size()));
-}
-
-template <size_t N>
-INLINE
-void drawEllipse(MTL::RenderCommandEncoder* enc,
-                 const simd::float2& p,
-                 const simd::float2& position,
-                 const simd::float3& color
-                 ) {
-    std::array<simd::float2, 2 * N + 1> vertices;
-    auto angleIncrement = 2.0f * std::numbers::pi_v<float> / N;
-    for (auto i = 0; i < N; ++i) {
-        auto angle = i * angleIncrement;
-        vertices[2 * i] = {
-            position.x + cosf(angle) * p.x,
-            position.y + sinf(angle) * p.y,
-        };
-        vertices[2 * i + 1] = { position.x, position.y };
-    }
-    vertices[2 * N] = { position.x + p.x, position.y};
-    drawPrimitive(enc, vertices, color);
-}
-
-template <size_t N>
-void drawCircle(MTL::RenderCommandEncoder* enc,
-                float p,
-                const simd::float2& position,
-                const simd::float3& color
-                ) {
-    drawEllipse<N>(enc, simd::float2{p, p}, position, color);
+    commands.draw(Pipeline::Primitives, primitiveType, vertices, color);
 }
 
 enum class PresentationStateTag: size_t { Edit, Animation };
 
+// How the yellow circle advances: by curve parameter, or at constant speed along the arc.
+enum class Pacing { Parameter, ArcLength };
+
 struct EditStateVars { };
-struct AnimationStateVars { float dt; };
+struct AnimationStateVars { float dt; Pacing pacing; };
 union PresentationStateVars {
     EditStateVars edit;
     AnimationStateVars anim;
@@ -101,7 +74,7 @@ union PresentationStateVars {
 
 struct PresentationState {
     PresentationStateTag tag;
-    CFTimeInterval enteredT;
+    Engine::Ticks enteredT;
     PresentationStateVars vars;
 };
 
@@ -125,236 +98,140 @@ const simd::float4x4 defaultCam = simd_float4x4{{
     {0, 0, 0, 1.0}
 }};
 
-struct TCR {
-    static constexpr simd::float4 tcr(
-                                      std::array<simd::float4, 2> p,
-                                      std::array<simd::float4, 2> v,
-                                      std::array<float, 2> t,
-                                      float tx
-                                      ) {
-        const auto a0 = p[0];
-        const auto a1 = v[0];
-        
-        const float tau = t[1] - t[0];
-        const simd::float4 eps = p[1] - p[0];
-        
-        const simd::float4 a2 = (eps * 3.0f) / (tau * tau) - (v[1] + v[0] * 2.0f) / tau;
-        const simd::float4 a3 = (eps * -2.0f) / (tau * tau * tau) + (v[1] + v[0]) / (tau * tau);
-        
-        const float dt = tx - t[0];
-        return a0 + a1 * dt + a2 * dt * dt + a3 * dt * dt * dt;
-    }
-    static constexpr float tension = -0.5f;
-    static constexpr size_t N = 10;
-    
-    int count;
-    float t[N];
-    simd::float4 p[N];
-    simd::float4 v[N];
-    
-    int index(float t) const {
-        for(auto i = 0; i < count; ++i) {
-            if(this->t[i] > t) return i-1;
-        }
-        return 0;
-    }
-    
-    void addControlPoint(const simd::float4& px, float tx) {
-        if(count == N) return;
-        
-        p[count] = px;
-        t[count] = tx;
-        count++;
-        if(count > 2) {
-            v[count-2] = velocity(count-2);
-        }
-        
+// Maximum chord deviation of adaptively tessellated curves, in pixels.
+constexpr float tessellationTolerance = 0.25f;
+
+void drawLineStrip(Engine::CommandList& commands,
+                   std::span<const simd::float2> vertices,
+                   const simd::float3& color
+                   ) {
+    drawPrimitive(commands, vertices, color, Engine::PrimitiveType::LineStrip);
+}
+
+void draw(Engine::CommandList& commands,
+          Shapes::Layer& shapes,
+          const TCR& tcr,
+          TCR::Cursor& cursor,
+          const PresentationState& state,
+          Engine::Ticks t,
+          std::span<const simd::float2> strip
+          ) {
+    if (tcr.size() == 0) {
         return;
     }
     
-    simd::float4 velocity(int i) const {
-        if (i < 0 || i >= count - 1) {
-            return {};
-        }
-        
-        simd::float4 v{};
-        for (auto j = i; j <= i+1; ++j) {
-            v = (p[i] - p[i-1]) / (t[i] - t[i-1]);
-        }
-        
-        return v * ((1.0f - tension) / 2.0f);
-    }
+    drawLineStrip(commands, strip, Colors::black);
     
-    simd::float4 weight(float tx) {
-        if (count == 0) {
-            return {};
-        }
-        
-        simd::float4 p_[4]{
-            {1,},
-            {0,1},
-            {0,0,1},
-            {0,0,0,1}
-        };
-        
-        if (count == 1 || tx <= t[0]) {
-            return p_[1];
+    if (state.tag == PresentationStateTag::Edit) {
+        for (auto i = 0; i < tcr.size(); ++i) {
+            shapes.circle(tcr.point(i), 1, Colors::red);
         }
-        
-        if (tx >= t[count-1]) {
-            return p_[2];
-        }
-        
-        int i = index(tx);
-        
-        auto v_ = std::array<simd::float4, 2>{};
-        for (auto j = i; j < i+2; ++j) {
-            v_[j-i] = (i-1 < 0 || i+1 > count) ? simd::float4{} :
-            ((p_[j-i+1] - p_[j-i])/(t[i] - t[i-1]) + (p_[j-i+2] - p_[j-i+1])/(t[i+1] - t[i])) *
-            ((1.0f - tension) / 2.0f);
-        }
-        
-        return tcr(
-                   std::array<simd::float4, 2>{p_[1], p_[2]},
-                   v_,
-                   std::array<float, 2>{t[i+1], t[i]},
-                   tx
-                   );
+        return;
     }
-    
-    simd::float4 operator()(float tx) {
-        if (count == 0) {
-            return {};
-        }
-        
-        if (count == 1 || tx <= t[0]) {
-            return p[0];
-        }
-        
-        if (tx >= t[count-1]) {
-            return p[count-1];
+    auto dt = state.vars.anim.dt;
+    auto ct = (float)Engine::seconds(t - state.enteredT);
+    auto t1 = (ct / dt) - floorf(ct / dt);
+    auto t_abs = state.vars.anim.pacing == Pacing::ArcLength ?
+        tcr.parameterAt(t1 * tcr.length()) : tcr.t[0] + t1 * dt;
+    // t_abs only moves forward from frame to frame until the animation
+    // loops, so the segment is found by walking on from the last one.
+    auto i = cursor.seek(tcr, t_abs);
+    auto w = tcr.weight(t_abs, i);
+
+    for(auto j = 0; j < 4; ++j ){
+        int index = i + j - 1;
+        if(index >= 0 && index < tcr.size()) {
+            auto color = w[j] < 0 ? simd::float3{0,1,1} : Colors::red;
+            shapes.circle(tcr.point(index), w[j], color);
         }
-        
-        int i = index(tx);
-        
-        return tcr(
-                   std::array<simd::float4, 2>{p[i], p[i+1]},
-                   std::array<simd::float4, 2>{v[i], v[i+1]},
-                   std::array<float, 2>{t[i], t[i+1]},
-                   tx
-                   );
     }
-    
-    void onDraw(MTL::RenderCommandEncoder* enc, const PresentationState& state) {
-        if (count == 0) {
-            return;
-        }
-        const int res = 500;
-        auto ts = t[0];
-        auto te = t[count - 1];
-        
-        std::array<simd::float2, res> vertices{};
-        for (auto i = 0; i < res; ++i) {
-            auto p = (*this)((te - ts) * ((float) i / res) + ts);
-            vertices[i] = p.xy;
-        }
-        
-        drawPrimitive(enc, vertices, Colors::black, MTL::PrimitiveTypeLineStrip);
-        
-        if (state.tag == PresentationStateTag::Edit) {
-            for (auto i = 0; i < count; ++i) {
-                drawCircle<20>(enc, 1, p[i].xy, Colors::red);
-            }
-            return;
-        }
-        auto dt = state.vars.anim.dt;
-        auto ct = (float)(CACurrentMediaTime() - state.enteredT);
-        auto t1 = (ct / dt) - floorf(ct / dt);
-        auto t_abs = t[0] + t1 * dt;
-        auto w = weight(t_abs);
-        auto i = index(t_abs);
-
-        for(auto j = 0; j < 4; ++j ){
-            int index = i + j - 1;
-            if(index >= 0 && index < count) {
-                auto color = w[j] < 0 ? simd::float3{0,1,1} : Colors::red;
-                drawCircle<20>(enc, w[j], p[index].xy, color);
-            }
-        }
 
-        auto r = (*this)(t_abs);
-        drawCircle<20>(enc, 1, r.xy, Colors::yellow);
-    }
-};
+    auto r = tcr(t_abs, i);
+    shapes.circle(r, 1, Colors::yellow);
+}
 
-struct Bezier {
-    static constexpr size_t N = 10;
-    
-    int count;
-    simd::float4 p[N];
-    
-    void addControlPoint(const simd::float4& px) {
-        if(count == N) return;
-        p[count] = px;
-        count++;
+void draw(Engine::CommandList& commands,
+          Shapes::Layer& shapes,
+          const Bezier& bezier,
+          const PresentationState& state,
+          std::span<const simd::float2> strip
+          ) {
+    if (bezier.size() == 0) {
         return;
     }
-    float weight(int i, float t) const {
-        float choose = 1;
-        for(auto j = 1; j <= i; j++) {
-            choose *= (float)(count - j) / j;
-        }
-        return choose * pow(t, i) * pow(1 - t, count - 1 - i);
-    }
-    simd::float4 operator()(float t) const {
-        if(count == 0) {
-            return {};
-        }
-        if(t < 0 || t > 1) {
-            return p[0];
-        }
-        simd::float4 result{};
-        for(int i = 0; i < count; i++) {
-            result += p[i] * weight(i, t);
-        }
-        return result;
-    }
-    void onDraw(MTL::RenderCommandEncoder* enc, const PresentationState& state) {
-        if (count == 0) {
-            return;
-        }
-        constexpr size_t res = 500;
-        std::array<simd::float2, res> vertices{};
-        for (auto i = 0; i < res; ++i) {
-            auto t = (float) i / res;
-            auto p = (*this)(t);
-            vertices[i] = p.xy;
-        }
-        drawPrimitive(enc, vertices, Colors::blue, MTL::PrimitiveTypeLineStrip);
-        
+    drawLineStrip(commands, strip, Colors::blue);
+    
 //        float t_n = 0;
 //        if (state.tag == PresentationStateTag::Animation) {
 //            auto dt = state.vars.anim.dt;
 //            auto ct = (float)(CACurrentMediaTime() - state.enteredT);
 //            t_n = (ct / dt) - floorf(ct / dt);
 //        }
-        
-        for(int i = 0; i < count; i++){
-            auto w = 1; //weight(i, t_n);
-            drawCircle<20>(enc, 1 * w, p[i].xy, Colors::red);
-        }
+    
+    for(int i = 0; i < bezier.size(); i++){
+        auto w = 1; //weight(i, t_n);
+        shapes.circle(bezier.point(i), 1 * w, Colors::red);
     }
+}
+
+// What onDraw needs of the simulation, as of time t. The curves are shared,
+// never modified once published.
+struct Snapshot {
+    PresentationState state;
+    simd::float4x4 cam;
+    TessellationMode tessellationMode;
+    std::shared_ptr<const TCR> tcr;
+    std::shared_ptr<const Bezier> bezier;
+    Engine::Ticks t;
 };
 
+// Simulation state, only touched by onInit and onIdle. Input callbacks
+// queue their events for the next onIdle, which publishes a snapshot for
+// onDraw, so the two threads share nothing else.
 PresentationState state;
 simd::float4x4 cam;
+TessellationMode tessellationMode = TessellationMode::Adaptive;
 TCR tcr;
 Bezier bezier;
+// The last published copies of the curves, null when there is none yet.
+std::shared_ptr<const TCR> publishedTCR;
+std::shared_ptr<const Bezier> publishedBezier;
+Engine::Mailbox<Engine::Input::Event, 64> input;
+Engine::TripleBuffer<Snapshot> snapshots;
+
+// Owned by onDraw. The caches re-tessellate only when the curves change, see
+// counters for how much; the cursor follows the animation along the TCR.
+TessellationCache tcrTessellation;
+TessellationCache bezierTessellation;
+TCR::Cursor animationCursor;
+Shapes::Layer shapes;
+
+// The curves change only on input, so they are copied only when their
+// revision moved since the last publish; otherwise the slot gets the
+// copies already shared.
+void publish(Engine::Ticks t) {
+    if (!publishedTCR || publishedTCR->revision != tcr.revision) {
+        publishedTCR = std::make_shared<const TCR>(tcr);
+    }
+    if (!publishedBezier || publishedBezier->revision != bezier.revision) {
+        publishedBezier = std::make_shared<const Bezier>(bezier);
+    }
+    auto& snapshot = snapshots.back();
+    snapshot.state = state;
+    snapshot.cam = cam;
+    snapshot.tessellationMode = tessellationMode;
+    snapshot.tcr = publishedTCR;
+    snapshot.bezier = publishedBezier;
+    snapshot.t = t;
+    snapshots.publish();
+}
 
 void copyTCRToBezier() {
-    for(int i = 0; i < tcr.count; ++i) {
-        bezier.addControlPoint(tcr.p[i] - simd::float4{2, 2});
+    Utility::SmallVector<simd::float2, TCR::N> points;
+    for(int i = 0; i < tcr.size(); ++i) {
+        points.push_back(tcr.point(i) - simd::float2{2, 2});
     }
+    bezier.addControlPoints(points);
 }
 
 void moveCamera() {
@@ -367,58 +244,115 @@ void moveCamera() {
     }
 }
 
-void Scene::onDraw(MTL::RenderCommandEncoder* enc) {
-    enc->setVertexBytes(&cam, sizeof(cam), (NS::UInteger)VertexInputIndex::Cam);
-    enc->setVertexBytes(&clip, sizeof(clip), (NS::UInteger)VertexInputIndex::Clip);
-    tcr.onDraw(enc, state);
-    bezier.onDraw(enc, state);
+void Scene::onDraw(Engine::CommandList& commands) {
+    // Shadows the simulation state, which belongs to the other thread.
+    const auto& [state, cam, tessellationMode, sharedTCR, sharedBezier, t] = snapshots.read();
+    const auto& tcr = *sharedTCR;
+    const auto& bezier = *sharedBezier;
+    
+    commands.bytes((uint8_t)VertexInputIndex::Cam, cam);
+    commands.bytes((uint8_t)VertexInputIndex::Clip, clip);
+    // NDC to pixels; the offset does not matter for measuring deviations.
+    const simd::float4x4 ndcToScreen{
+        simd::float4{viewport.x / 2, 0, 0, 0},
+        simd::float4{0, viewport.y / 2, 0, 0},
+        simd::float4{0, 0, 1, 0},
+        simd::float4{0, 0, 0, 1},
+    };
+    const TessellationParams tessellation{tessellationMode, tessellationTolerance, ndcToScreen * clip * cam};
+    
+    shapes.clear();
+    draw(commands, shapes, tcr, animationCursor, state, t, tcrTessellation.update(tcr, tessellation));
+    draw(commands, shapes, bezier, state, bezierTessellation.update(bezier, tessellation));
+    // Control points and the moving circles, over both curves.
+    Shapes::draw(commands, shapes, Shapes::Pipelines{Pipeline::Ellipses, Pipeline::Triangles});
 }
 
-void Scene::onInit(CFTimeInterval t) {
-    state.enteredT = CACurrentMediaTime();
+void Scene::onInit(const Engine::FrameContext& frame) {
+    state = PresentationState{.tag=PresentationStateTag::Edit, .enteredT=frame.time};
     cam = defaultCam;
     tcr = TCR{};
     bezier = Bezier{};
+    publishedTCR = nullptr;
+    publishedBezier = nullptr;
+    // Revisions restart with the curves.
+    tcrTessellation = TessellationCache{};
+    bezierTessellation = TessellationCache{};
+    animationCursor = TCR::Cursor{};
+    publish(frame.time);
 }
 
-void Scene::onMouseClicked(Engine::Input::MouseButton button, Engine::Input::ButtonState buttonState, simd::float2 c) {
+// Input is applied at the time of the onIdle handling it.
+void click(Engine::Input::MouseButton button, Engine::Input::ButtonState buttonState, simd::float2 c, Engine::Ticks t) {
     if (button == Engine::Input::MouseButton::Left && buttonState == Engine::Input::ButtonState::Down &&
         state.tag == PresentationStateTag::Edit) {
-        tcr.addControlPoint(simd::float4{
+        tcr.addControlPoint(simd::float2{
             (c.x / 6 - cam.columns[3][0]) / cam.columns[0][0],
             (c.y / 6 - cam.columns[3][1]) / cam.columns[1][1]
-        }, CACurrentMediaTime() - state.enteredT);
+        }, Engine::seconds(t - state.enteredT));
     }
 }
 
-bool Scene::onKey(Engine::Input::KeyboardButton button, Engine::Input::ButtonState buttonState) {
+void key(Engine::Input::KeyboardButton button, Engine::Ticks t) {
     if (button == Engine::Input::KeyboardButton::SPACEBAR
         && state.tag == PresentationStateTag::Edit
-        && tcr.count
+        && tcr.size()
         ) {
         state = PresentationState{
             .tag=PresentationStateTag::Animation,
-            .enteredT=CACurrentMediaTime()
+            .enteredT=t
         };
-        state.vars.anim = {tcr.t[tcr.count-1] - tcr.t[0]};
+        state.vars.anim = {tcr.t[tcr.size()-1] - tcr.t[0], Pacing::Parameter};
         copyTCRToBezier();
-        return true;
     }
     if (button == Engine::Input::KeyboardButton::S) {
         moveCamera();
-        return true;
     }
-    return false;
+    if (button == Engine::Input::KeyboardButton::L && state.tag == PresentationStateTag::Animation) {
+        auto& pacing = state.vars.anim.pacing;
+        pacing = pacing == Pacing::Parameter ? Pacing::ArcLength : Pacing::Parameter;
+    }
+    if (button == Engine::Input::KeyboardButton::T) {
+        tessellationMode = tessellationMode == TessellationMode::Adaptive ? TessellationMode::Uniform : TessellationMode::Adaptive;
+    }
 }
 
-void Scene::onMouseMoved(simd::float2 c) {
+void Scene::onMouseClicked(Engine::Input::MouseButton button, Engine::Input::ButtonState buttonState, simd::float2 c) {
+    input.push(Engine::Input::Event{
+        .type=Engine::Input::Event::Type::MouseClick,
+        .position=c,
+        .button=button,
+        .state=buttonState
+    });
 }
 
-void Scene::onIdle(CFTimeInterval endT) {
+// Keys are handled later on the simulation thread, so whether they are
+// handled is decided by key alone.
+bool Scene::onKey(Engine::Input::KeyboardButton button, Engine::Input::ButtonState buttonState) {
+    switch (button) {
+        case Engine::Input::KeyboardButton::SPACEBAR:
+        case Engine::Input::KeyboardButton::S:
+        case Engine::Input::KeyboardButton::L:
+        case Engine::Input::KeyboardButton::T:
+            input.push(Engine::Input::Event{.type=Engine::Input::Event::Type::Key, .key=button, .state=buttonState});
+            return true;
+        default:
+            return false;
+    }
 }
 
-Engine::Renderer* Scene::createRenderer(MTK::View *mtkView) {
-    return new Renderer(mtkView, *this);
+void Scene::onMouseMoved(simd::float2 c) {
+}
+
+void Scene::onIdle(const Engine::FrameContext& frame) {
+    input.drain([&frame](const Engine::Input::Event& event) {
+        if (event.type == Engine::Input::Event::Type::MouseClick) {
+            click(event.button, event.state, event.position, frame.time);
+        } else if (event.type == Engine::Input::Event::Type::Key) {
+            key(event.key, frame.time);
+        }
+    });
+    publish(frame.time);
 }
 
 } /* namespace S13E02 */
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../../Utility/ShapeTypes.hh"
+
 namespace Scenes {
 namespace S13E02 {
 
@@ -7,7 +9,8 @@ enum class VertexInputIndex {
     Vertices,
     Cam,
     Clip,
-    Color
+    Color,
+    Instances
 };
 
 } /* namespace S1302 */
@@ -43,6 +43,43 @@ namespace Scenes {
             return out;
         }
         
+        // One instance of the unit circle mesh per ellipse of the shape layer.
+        vertex RasterizerData
+        ellipseVertexShader(uint vertexID [[vertex_id]],
+                            uint instanceID [[instance_id]],
+                            constant vector_float2 *vertices [[buffer(VertexInputIndex::Vertices)]],
+                            constant float4x4 *cam [[buffer(VertexInputIndex::Cam)]],
+                            constant float4x4 *clip [[buffer(VertexInputIndex::Clip)]],
+                            constant Shapes::EllipseInstance *instances [[buffer(VertexInputIndex::Instances)]])
+        {
+            constant Shapes::EllipseInstance& instance = instances[instanceID];
+            
+            RasterizerData out;
+            float4 obj = float4(instance.center + vertices[vertexID] * instance.radii * instance.facing, 0, 1);
+            out.position = (*clip * *cam) * obj;
+            out.position.z = 0.0;
+            out.color = vector_float4(instance.color, 0);
+            return out;
+        }
+        
+        // Three vertices per triangle of the shape layer.
+        vertex RasterizerData
+        triangleVertexShader(uint vertexID [[vertex_id]],
+                             uint instanceID [[instance_id]],
+                             constant float4x4 *cam [[buffer(VertexInputIndex::Cam)]],
+                             constant float4x4 *clip [[buffer(VertexInputIndex::Clip)]],
+                             constant Shapes::TriangleInstance *instances [[buffer(VertexInputIndex::Instances)]])
+        {
+            constant Shapes::TriangleInstance& instance = instances[instanceID];
+            
+            RasterizerData out;
+            float4 obj = float4(instance.corners[vertexID], 0, 1);
+            out.position = (*clip * *cam) * obj;
+            out.position.z = 0.0;
+            out.color = vector_float4(instance.color, 0);
+            return out;
+        }
+        
         fragment float4 fragmentShader(RasterizerData in [[stage_in]])
         {
             // Return the interpolated color.
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <simd/simd.h>
+
+#include "../../Engine/SoftwareRenderer.hh"
+#include "ShaderTypes.hh"
+#include "Pipelines.hh"
+
+// C++ counterparts of Shaders.metal for the software rasterizer.
+namespace Scenes {
+namespace S13E02 {
+namespace Software {
+
+using Engine::Software::Buffers;
+using Engine::Software::VertexOut;
+
+// Object space to clip space through the camera, z flattened to 0.
+inline simd::float4 objectToClip(const simd::float2& position, const Buffers& buffers) {
+    const auto& cam = *buffers.get<simd::float4x4>(VertexInputIndex::Cam);
+    const auto& clip = *buffers.get<simd::float4x4>(VertexInputIndex::Clip);
+
+    simd::float4 out = (clip * cam) * simd::float4{position.x, position.y, 0, 1};
+    out.z = 0.0f;
+    return out;
+}
+
+inline VertexOut vertexShader(const Buffers& buffers, uint32_t vertexID, uint32_t) {
+    const auto vertices = buffers.get<simd::float2>(VertexInputIndex::Vertices);
+    const auto color = buffers.get<simd::float3>(VertexInputIndex::Color);
+
+    return VertexOut{
+        objectToClip(vertices[vertexID], buffers),
+        simd::float4{color->x, color->y, color->z, 0},
+    };
+}
+
+inline VertexOut ellipseVertexShader(const Buffers& buffers, uint32_t vertexID, uint32_t instanceID) {
+    const auto vertices = buffers.get<simd::float2>(VertexInputIndex::Vertices);
+    const auto& instance = buffers.get<Shapes::EllipseInstance>(VertexInputIndex::Instances)[instanceID];
+
+    return VertexOut{
+        objectToClip(instance.center + vertices[vertexID] * instance.radii * instance.facing, buffers),
+        simd::float4{instance.color.x, instance.color.y, instance.color.z, 0},
+    };
+}
+
+inline VertexOut triangleVertexShader(const Buffers& buffers, uint32_t vertexID, uint32_t instanceID) {
+    const auto& instance = buffers.get<Shapes::TriangleInstance>(VertexInputIndex::Instances)[instanceID];
+
+    return VertexOut{
+        objectToClip(instance.corners[vertexID], buffers),
+        simd::float4{instance.color.x, instance.color.y, instance.color.z, 0},
+    };
+}
+
+inline const Engine::Software::Program& program() {
+    static_assert(Pipeline::Primitives == 0 && Pipeline::Ellipses == 1 && Pipeline::Triangles == 2);
+    static const Engine::Software::VertexShader pipelines[Pipeline::Count] = {
+        vertexShader,
+        ellipseVertexShader,
+        triangleVertexShader,
+    };
+    static const Engine::Software::Program program{
+        pipelines,
+        Engine::Bindings{
+            .vertices=(uint8_t)VertexInputIndex::Vertices,
+            .color=(uint8_t)VertexInputIndex::Color,
+            .instances=(uint8_t)VertexInputIndex::Instances
+        },
+        ClearColor,
+    };
+    return program;
+}
+
+} /* namespace Software */
+} /* namespace S13E02 */
+} /* namespace Scenes */
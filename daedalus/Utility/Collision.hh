@@ -0,0 +1,333 @@
+#pragma once
+
+#include <simd/simd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+
+#pragma mark - Collision
+
+namespace Collision
+{
+    // Filled ellipse: its center, the radii along its own axes and the
+    // direction of the first axis, a unit vector.
+    struct Ellipse {
+        simd::float2 center;
+        simd::float2 radii;
+        simd::float2 axis = {1, 0};
+    };
+
+    struct Contact {
+        bool overlap;
+        // How far a has to move along normal for the two to be apart: the
+        // overlap of their projections onto it. 0 when they are apart.
+        float depth;
+        // Unit normal of b's boundary where a goes deepest into it, pointing
+        // out of b.
+        simd::float2 normal;
+        // The point of a's boundary deepest inside b, measured in b's own
+        // metric; when apart, the one nearest to b.
+        simd::float2 point;
+    };
+
+    namespace detail
+    {
+        struct Point {
+            double x, y;
+        };
+
+        // Scalars that mix with V without a narrowing conversion.
+        template <class V>
+        using Scalar = std::conditional_t<std::is_same_v<V, double>, double, float>;
+
+        // b in the frame where a is the unit circle at the origin: the points
+        // u with u.P u + 2 r.u + s < 0 are inside b. V is double, or
+        // simd::float4 for four bs at once.
+        template <class V>
+        struct Conic {
+            V p11, p12, p22;
+            V r1, r2;
+            V s;
+        };
+
+        // The frame is u = diag(1 / a.radii) a.rotation^-1 (x - a.center); b's
+        // matrix in it is K^T K with K mapping u to b's own unit circle frame.
+        template <class V>
+        Conic<V> relative(const Ellipse& a, V bcx, V bcy, V brx, V bry, V bax, V bay) {
+            const Scalar<V> l0x = a.axis.x * a.radii.x, l0y = a.axis.y * a.radii.x;
+            const Scalar<V> l1x = -a.axis.y * a.radii.y, l1y = a.axis.x * a.radii.y;
+            const V w0x = bax / brx, w0y = bay / brx;
+            const V w1x = -bay / bry, w1y = bax / bry;
+            const V k00 = w0x * l0x + w0y * l0y, k10 = w1x * l0x + w1y * l0y;
+            const V k01 = w0x * l1x + w0y * l1y, k11 = w1x * l1x + w1y * l1y;
+            const V dx = Scalar<V>(a.center.x) - bcx, dy = Scalar<V>(a.center.y) - bcy;
+            const V e0 = w0x * dx + w0y * dy, e1 = w1x * dx + w1y * dy;
+            return Conic<V>{
+                k00 * k00 + k10 * k10, k00 * k01 + k10 * k11, k01 * k01 + k11 * k11,
+                k00 * e0 + k10 * e1, k01 * e0 + k11 * e1,
+                e0 * e0 + e1 * e1 - 1,
+            };
+        }
+
+        inline Conic<double> relative(const Ellipse& a, const Ellipse& b) {
+            return relative<double>(a, b.center.x, b.center.y, b.radii.x, b.radii.y, b.axis.x, b.axis.y);
+        }
+
+        // The characteristic polynomial det(lambda A - B) of the two conics
+        // is -(lambda^3 + c2 lambda^2 + c1 lambda + c0). The ellipses are apart
+        // exactly when it has two distinct negative roots, and touch when
+        // they coincide. One root is always positive, so that is three
+        // distinct real roots, a positive discriminant, of which two are
+        // negative, which for real roots Descartes' rule of signs counts
+        // from the coefficients.
+        template <class V>
+        struct Characteristic {
+            V c2, c1, c0;
+            V discriminant;
+        };
+
+        template <class V>
+        Characteristic<V> characteristic(const Conic<V>& b) {
+            const V trace = b.p11 + b.p22;
+            const V c2 = b.s - trace;
+            const V c1 = b.p11 * b.p22 - b.p12 * b.p12 + b.r1 * b.r1 + b.r2 * b.r2 - trace * b.s;
+            const V c0 = b.p11 * b.p22 * b.s - b.p11 * b.r2 * b.r2 - b.p12 * b.p12 * b.s
+                + 2 * b.p12 * b.r1 * b.r2 - b.p22 * b.r1 * b.r1;
+            const V discriminant = 18 * c2 * c1 * c0 - 4 * c2 * c2 * c2 * c0 + c2 * c2 * c1 * c1
+                - 4 * c1 * c1 * c1 - 27 * c0 * c0;
+            return Characteristic<V>{c2, c1, c0, discriminant};
+        }
+
+        inline bool separated(double c2, double c1, double discriminant) {
+            return discriminant > 0 && (c2 > 0 || c1 < 0);
+        }
+
+        inline double evaluate(const double* c, int n, double t) {
+            double p = c[n];
+            for (int i = n - 1; i >= 0; --i) {
+                p = p * t + c[i];
+            }
+            return p;
+        }
+
+        // Real roots of c[0] + c[1] t + ... + c[n] t^n in [lo, hi], n <= 4,
+        // in ascending order. Up to quadratics they are taken in closed form.
+        // Above, between consecutive roots of the derivative the polynomial
+        // is monotone, so each sign change there brackets exactly one root,
+        // polished by Newton steps kept inside the bracket. Roots where it
+        // touches zero without crossing are not reported.
+        inline int realRoots(const double* c, int n, double lo, double hi, double* roots) {
+            double scale = 0;
+            for (int i = 0; i <= n; ++i) {
+                scale = std::max(scale, std::abs(c[i]));
+            }
+            // Negligible leading terms only add roots far outside [-1, 1].
+            while (n > 0 && std::abs(c[n]) <= 1e-12 * scale) {
+                n--;
+            }
+            if (n == 0) {
+                return 0;
+            }
+            if (n <= 2) {
+                // Closed form, in the form that does not cancel.
+                double candidates[2];
+                int found = 0;
+                if (n == 1) {
+                    candidates[found++] = -c[0] / c[1];
+                } else {
+                    const double discriminant = c[1] * c[1] - 4 * c[2] * c[0];
+                    if (discriminant >= 0) {
+                        const double q = -(c[1] + std::copysign(std::sqrt(discriminant), c[1])) / 2;
+                        candidates[found++] = q / c[2];
+                        if (q != 0) {
+                            candidates[found++] = c[0] / q;
+                        }
+                    }
+                    if (found == 2 && candidates[0] > candidates[1]) {
+                        std::swap(candidates[0], candidates[1]);
+                    }
+                }
+                int count = 0;
+                for (int i = 0; i < found; ++i) {
+                    if (candidates[i] >= lo && candidates[i] <= hi) {
+                        roots[count++] = candidates[i];
+                    }
+                }
+                return count;
+            }
+            double derivative[4];
+            for (int i = 0; i < n; ++i) {
+                derivative[i] = (i + 1) * c[i + 1];
+            }
+            double breaks[6];
+            breaks[0] = lo;
+            const int critical = realRoots(derivative, n - 1, lo, hi, breaks + 1);
+            breaks[critical + 1] = hi;
+
+            int count = 0;
+            for (int i = 0; i <= critical; ++i) {
+                double a = breaks[i], b = breaks[i + 1];
+                double fa = evaluate(c, n, a), fb = evaluate(c, n, b);
+                if (fa == 0) {
+                    if (count == 0 || roots[count - 1] != a) {
+                        roots[count++] = a;
+                    }
+                    continue;
+                }
+                if (fb == 0 || (fa < 0) == (fb < 0)) {
+                    continue;
+                }
+                double t = (a + b) / 2;
+                for (int iteration = 0; iteration < 64; ++iteration) {
+                    const double f = evaluate(c, n, t);
+                    if (f == 0) {
+                        break;
+                    }
+                    ((f < 0) == (fa < 0) ? a : b) = t;
+                    const double slope = evaluate(derivative, n - 1, t);
+                    const double newton = slope != 0 ? t - f / slope : a;
+                    const double next = newton > a && newton < b ? newton : (a + b) / 2;
+                    if (std::abs(next - t) <= 1e-15 * (1 + std::abs(t))) {
+                        t = next;
+                        break;
+                    }
+                    t = next;
+                }
+                roots[count++] = t;
+            }
+            if (evaluate(c, n, hi) == 0 && (count == 0 || roots[count - 1] != hi)) {
+                roots[count++] = hi;
+            }
+            return count;
+        }
+
+        // Where on the unit circle u = (cos theta, sin theta) b's quadratic
+        // is smallest, and its value there. Its derivative in theta vanishes
+        // where, with t = tan(theta / 2), a quartic in t does. Each half of
+        // the circle is searched with t in [-1, 1], the far half turned by
+        // pi, which negates the linear terms, so the roots are bracketed
+        // tightly without a bound on them.
+        struct Extremum {
+            Point u;
+            double q;
+        };
+
+        inline Extremum deepest(const Conic<double>& b) {
+            auto q = [&](double c, double s) {
+                return Extremum{
+                    Point{c, s},
+                    b.p11 * c * c + 2 * b.p12 * c * s + b.p22 * s * s + 2 * (b.r1 * c + b.r2 * s) + b.s,
+                };
+            };
+            const double k = b.p22 - b.p11;
+            auto best = q(1, 0);
+            for (int half = 0; half < 2; ++half) {
+                const double r1 = half ? -b.r1 : b.r1, r2 = half ? -b.r2 : b.r2;
+                const double quartic[5] = {
+                    b.p12 + r2,
+                    2 * (k - r1),
+                    -6 * b.p12,
+                    -2 * (k + r1),
+                    b.p12 - r2,
+                };
+                double roots[4];
+                const int count = realRoots(quartic, 4, -1, 1, roots);
+                for (int i = 0; i < count; ++i) {
+                    // cos and sin of theta from t, turned by pi on the far half.
+                    const double t = roots[i], sign = half ? -1 : 1;
+                    const auto candidate = q(sign * (1 - t * t) / (1 + t * t), sign * 2 * t / (1 + t * t));
+                    if (candidate.q < best.q) {
+                        best = candidate;
+                    }
+                }
+            }
+            return best;
+        }
+
+        // Largest projection of e onto the unit vector n.
+        inline double support(const Ellipse& e, Point n) {
+            const double along = n.x * e.axis.x + n.y * e.axis.y;
+            const double across = -n.x * e.axis.y + n.y * e.axis.x;
+            return n.x * e.center.x + n.y * e.center.y
+                + std::sqrt(along * along * e.radii.x * e.radii.x + across * across * e.radii.y * e.radii.y);
+        }
+
+        inline Point toWorld(const Ellipse& a, Point u) {
+            const double x = u.x * a.radii.x, y = u.y * a.radii.y;
+            return Point{
+                a.center.x + x * a.axis.x - y * a.axis.y,
+                a.center.y + x * a.axis.y + y * a.axis.x,
+            };
+        }
+
+        // Out of b at p: the gradient of b's quadratic.
+        inline Point normal(const Ellipse& b, Point p) {
+            const double dx = p.x - b.center.x, dy = p.y - b.center.y;
+            const double along = (dx * b.axis.x + dy * b.axis.y) / (b.radii.x * b.radii.x);
+            const double across = (-dx * b.axis.y + dy * b.axis.x) / (b.radii.y * b.radii.y);
+            const Point n{along * b.axis.x - across * b.axis.y, along * b.axis.y + across * b.axis.x};
+            const double length = std::sqrt(n.x * n.x + n.y * n.y);
+            return length > 0 ? Point{n.x / length, n.y / length} : Point{1, 0};
+        }
+    }
+
+    // Exact, up to rounding, for any two ellipses. Touching counts.
+    inline bool overlap(const Ellipse& a, const Ellipse& b) {
+        const auto c = detail::characteristic(detail::relative(a, b));
+        return !detail::separated(c.c2, c.c1, c.discriminant);
+    }
+
+    // Several root solves where overlap() is a few dozen flops, so meant for
+    // the pairs that overlap() or the batch version below have found.
+    inline Contact contact(const Ellipse& a, const Ellipse& b) {
+        const auto conic = detail::relative(a, b);
+        const auto c = detail::characteristic(conic);
+        const bool overlap = !detail::separated(c.c2, c.c1, c.discriminant);
+        const auto deepest = detail::deepest(conic);
+
+        auto point = detail::toWorld(a, deepest.u);
+        auto n = detail::normal(b, point);
+        if (overlap && deepest.q > 0) {
+            // a's boundary stays outside b, so b lies inside a: take the
+            // point of b's boundary deepest in a, and push a the other way.
+            const auto inner = detail::deepest(detail::relative(b, a));
+            point = detail::toWorld(b, inner.u);
+            const auto outward = detail::normal(a, point);
+            n = detail::Point{-outward.x, -outward.y};
+        }
+        const double depth = overlap ? detail::support(b, n) + detail::support(a, detail::Point{-n.x, -n.y}) : 0;
+        return Contact{
+            overlap,
+            float(std::max(depth, 0.0)),
+            simd::float2{float(n.x), float(n.y)},
+            simd::float2{float(point.x), float(point.y)},
+        };
+    }
+
+    // overlap(a, others[i]) into result[i], four others at a time in
+    // simd::float4 lanes. Returns how many overlap a.
+    inline size_t overlap(const Ellipse& a, std::span<const Ellipse> others, std::span<bool> result) {
+        size_t overlapping = 0;
+        for (size_t i = 0; i < others.size(); i += 4) {
+            simd::float4 cx, cy, rx, ry, ax, ay;
+            for (int lane = 0; lane < 4; ++lane) {
+                // Lanes past the end repeat the last ellipse.
+                const auto& b = others[std::min(i + lane, others.size() - 1)];
+                cx[lane] = b.center.x;
+                cy[lane] = b.center.y;
+                rx[lane] = b.radii.x;
+                ry[lane] = b.radii.y;
+                ax[lane] = b.axis.x;
+                ay[lane] = b.axis.y;
+            }
+            const auto c = detail::characteristic(detail::relative(a, cx, cy, rx, ry, ax, ay));
+            for (size_t lane = 0; lane < 4 && i + lane < others.size(); ++lane) {
+                result[i + lane] = !detail::separated(c.c2[lane], c.c1[lane], c.discriminant[lane]);
+                overlapping += result[i + lane];
+            }
+        }
+        return overlapping;
+    }
+}
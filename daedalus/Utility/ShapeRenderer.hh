@@ -0,0 +1,38 @@
+#pragma once
+
+#include <algorithm>
+#include <span>
+
+#include "../Engine/CommandList.hh"
+#include "Shapes.hh"
+
+#pragma mark - ShapeRenderer
+
+namespace Shapes
+{
+    // Pipelines of the scene that draw a Layer's instances.
+    struct Pipelines {
+        Engine::PipelineId ellipses;
+        Engine::PipelineId triangles;
+    };
+
+    // Records the layer as instanced draws: triangles under the ellipses, the
+    // ellipses over the shared unit circle mesh, triangles over them. Lists
+    // are split into chunks that fit in a setVertexBytes call.
+    inline void draw(Engine::CommandList& commands, const Layer& layer, const Pipelines& pipelines) {
+        auto drawInstances = [&](auto instances, Engine::PipelineId pipeline, Engine::PrimitiveType primitive, auto mesh, uint32_t vertexCount) {
+            using Instance = typename decltype(instances)::value_type;
+            constexpr size_t chunk = 4000 / sizeof(Instance);
+            for (size_t begin = 0; begin < instances.size(); begin += chunk) {
+                const size_t count = std::min(chunk, instances.size() - begin);
+                commands.drawInstanced(pipeline, primitive, mesh, instances.subspan(begin, count), vertexCount);
+            }
+        };
+
+        const auto& mesh = Layer::mesh();
+        const std::span<const simd::float2> noMesh;
+        drawInstances(std::span<const TriangleInstance>(layer.under), pipelines.triangles, Engine::PrimitiveType::Triangle, noMesh, 3);
+        drawInstances(std::span<const EllipseInstance>(layer.ellipses), pipelines.ellipses, Engine::PrimitiveType::TriangleStrip, std::span<const simd::float2>(mesh), (uint32_t)mesh.size());
+        drawInstances(std::span<const TriangleInstance>(layer.over), pipelines.triangles, Engine::PrimitiveType::Triangle, noMesh, 3);
+    }
+}
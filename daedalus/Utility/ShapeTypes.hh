@@ -0,0 +1,23 @@
+#pragma once
+
+#include <simd/simd.h>
+
+// Per-instance records of the shape layer, shared between C++ and the
+// instanced vertex shaders.
+namespace Shapes {
+
+// Unit circle mesh vertex v lands at center + v * radii * facing.
+struct EllipseInstance {
+    vector_float2 center;
+    vector_float2 radii;
+    vector_float2 facing;
+    vector_float3 color;
+};
+
+// Corners in the same space as the scene's other vertices.
+struct TriangleInstance {
+    vector_float2 corners[3];
+    vector_float3 color;
+};
+
+} /* namespace Shapes */
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <simd/simd.h>
+#include <array>
+#include <cstddef>
+#include <numbers>
+#include <vector>
+
+#include "ShapeTypes.hh"
+
+#pragma mark - Shapes
+
+namespace Shapes
+{
+    namespace detail
+    {
+        // Taylor series after reducing x to [-pi, pi], where 30 terms reach
+        // double precision. Only meant for building tables at compile time.
+        constexpr double reduce(double x) {
+            constexpr double pi = std::numbers::pi;
+            while (x > pi) x -= 2 * pi;
+            while (x < -pi) x += 2 * pi;
+            return x;
+        }
+
+        constexpr double sin(double x) {
+            x = reduce(x);
+            double term = x, sum = x;
+            for (auto k = 1; k < 30; ++k) {
+                term *= -x * x / ((2 * k) * (2 * k + 1));
+                sum += term;
+            }
+            return sum;
+        }
+
+        constexpr double cos(double x) {
+            x = reduce(x);
+            double term = 1, sum = 1;
+            for (auto k = 1; k < 30; ++k) {
+                term *= -x * x / ((2 * k - 1) * (2 * k));
+                sum += term;
+            }
+            return sum;
+        }
+    }
+
+    // cos and sin of the angles 2 pi i / N.
+    template <size_t N>
+    struct UnitCircle {
+        std::array<float, N> cos;
+        std::array<float, N> sin;
+    };
+
+    template <size_t N>
+    constexpr UnitCircle<N> unitCircle = [] {
+        UnitCircle<N> c{};
+        for (size_t i = 0; i < N; ++i) {
+            const double angle = 2 * std::numbers::pi * i / N;
+            c.cos[i] = (float)detail::cos(angle);
+            c.sin[i] = (float)detail::sin(angle);
+        }
+        return c;
+    }();
+
+    // Triangle strip of an axis-aligned ellipse with N rim vertices, every
+    // other vertex being the center. One multiply-add per coordinate.
+    template <size_t N>
+    std::array<simd::float2, 2 * N + 1> ellipse(const simd::float2& radii, const simd::float2& center) {
+        constexpr const auto& circle = unitCircle<N>;
+        std::array<simd::float2, 2 * N + 1> vertices;
+        for (size_t i = 0; i < N; ++i) {
+            vertices[2 * i] = {
+                center.x + circle.cos[i] * radii.x,
+                center.y + circle.sin[i] * radii.y,
+            };
+            vertices[2 * i + 1] = center;
+        }
+        vertices[2 * N] = { center.x + radii.x, center.y };
+        return vertices;
+    }
+
+    // Instances of one frame's ellipses and triangles, drawn with one
+    // instanced draw per list: triangles under the ellipses, the ellipses,
+    // then triangles over them. Shapes that must cover one another as whole
+    // groups, like two overlapping figures, go in separate layers drawn in
+    // order. Holds no GPU state, see ShapeRenderer.hh.
+    struct Layer {
+        // Rim vertices of the shared unit circle mesh.
+        static constexpr size_t Resolution = 30;
+
+        enum class Depth { Under, Over };
+
+        std::vector<TriangleInstance> under;
+        std::vector<EllipseInstance> ellipses;
+        std::vector<TriangleInstance> over;
+
+        static const std::array<simd::float2, 2 * Resolution + 1>& mesh() {
+            static const auto mesh = Shapes::ellipse<Resolution>(simd::float2{1, 1}, simd::float2{0, 0});
+            return mesh;
+        }
+
+        bool empty() const {
+            return under.empty() && ellipses.empty() && over.empty();
+        }
+
+        // Keeps the capacity for the next frame.
+        void clear() {
+            under.clear();
+            ellipses.clear();
+            over.clear();
+        }
+
+        void ellipse(const simd::float2& center,
+                     const simd::float2& radii,
+                     const simd::float3& color,
+                     const simd::float2& facing = {1, 1}
+                     ) {
+            ellipses.push_back(EllipseInstance{center, radii, facing, color});
+        }
+
+        void circle(const simd::float2& center, float r, const simd::float3& color) {
+            ellipse(center, simd::float2{r, r}, color);
+        }
+
+        void triangle(const simd::float2& a,
+                      const simd::float2& b,
+                      const simd::float2& c,
+                      const simd::float3& color,
+                      Depth depth = Depth::Over
+                      ) {
+            (depth == Depth::Under ? under : over).push_back(TriangleInstance{{a, b, c}, color});
+        }
+    };
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+#pragma mark - SmallVector
+
+namespace Utility
+{
+    // Growable array keeping up to Inline elements in place, so small
+    // instances live without a heap allocation. Past that it doubles its heap
+    // block. Only trivially copyable elements are supported: they are moved
+    // around with memcpy and never destroyed.
+    template <class T, size_t Inline>
+    class SmallVector {
+        static_assert(std::is_trivially_copyable_v<T>, "SmallVector relocates elements with memcpy");
+        static_assert(Inline > 0, "SmallVector needs inline capacity");
+
+    public:
+        SmallVector() = default;
+
+        SmallVector(const SmallVector& other) {
+            assign(other);
+        }
+
+        SmallVector(SmallVector&& other) {
+            take(other);
+        }
+
+        SmallVector& operator=(const SmallVector& other) {
+            if (this != &other) {
+                _size = 0;
+                assign(other);
+            }
+            return *this;
+        }
+
+        SmallVector& operator=(SmallVector&& other) {
+            if (this != &other) {
+                release();
+                take(other);
+            }
+            return *this;
+        }
+
+        ~SmallVector() {
+            release();
+        }
+
+        T* data() { return _heap ? _heap : reinterpret_cast<T*>(_inline); }
+        const T* data() const { return _heap ? _heap : reinterpret_cast<const T*>(_inline); }
+        size_t size() const { return _size; }
+        size_t capacity() const { return _heap ? _capacity : Inline; }
+        bool empty() const { return _size == 0; }
+
+        T* begin() { return data(); }
+        T* end() { return data() + _size; }
+        const T* begin() const { return data(); }
+        const T* end() const { return data() + _size; }
+
+        T& operator[](size_t i) { return data()[i]; }
+        const T& operator[](size_t i) const { return data()[i]; }
+        T& back() { return data()[_size - 1]; }
+        const T& back() const { return data()[_size - 1]; }
+
+        void push_back(const T& value) {
+            if (_size == capacity()) {
+                // value may alias an element, copy it before the block moves.
+                const T copy = value;
+                reserve(_size * 2);
+                data()[_size++] = copy;
+                return;
+            }
+            data()[_size++] = value;
+        }
+
+        // New elements are value-initialized.
+        void resize(size_t size) {
+            if (size > capacity()) {
+                reserve(std::max(size, capacity() * 2));
+            }
+            for (auto i = _size; i < size; ++i) {
+                data()[i] = T{};
+            }
+            _size = size;
+        }
+
+        // Like resize(), but new elements are left uninitialized, for callers
+        // about to write them anyway.
+        void resize_for_overwrite(size_t size) {
+            if (size > capacity()) {
+                reserve(std::max(size, capacity() * 2));
+            }
+            _size = size;
+        }
+
+        void reserve(size_t capacity) {
+            if (capacity <= this->capacity()) {
+                return;
+            }
+            T* heap = static_cast<T*>(std::malloc(capacity * sizeof(T)));
+            if (!heap) {
+                throw std::bad_alloc();
+            }
+            if (_size) {
+                std::memcpy(heap, data(), _size * sizeof(T));
+            }
+            std::free(_heap);
+            _heap = heap;
+            _capacity = capacity;
+        }
+
+        void clear() {
+            _size = 0;
+        }
+
+    private:
+        void assign(const SmallVector& other) {
+            reserve(other._size);
+            if (other._size) {
+                std::memcpy(data(), other.data(), other._size * sizeof(T));
+            }
+            _size = other._size;
+        }
+
+        void take(SmallVector& other) {
+            if (other._heap) {
+                _heap = other._heap;
+                _capacity = other._capacity;
+                _size = other._size;
+                other._heap = nullptr;
+                other._capacity = 0;
+                other._size = 0;
+            } else {
+                assign(other);
+            }
+        }
+
+        void release() {
+            std::free(_heap);
+            _heap = nullptr;
+            _capacity = 0;
+            _size = 0;
+        }
+
+        T* _heap = nullptr;
+        size_t _size = 0;
+        size_t _capacity = 0;
+        alignas(T) unsigned char _inline[Inline * sizeof(T)];
+    };
+}
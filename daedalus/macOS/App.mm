@@ -3,12 +3,13 @@
 #import <MetalKit/MetalKit.h>
 #import <QuartzCore/QuartzCore.h>
 #import <GameController/GameController.h>
+#include <iterator>
 #include <memory>
 #include "../Engine/Engine.hh"
+#include "../Engine/Clock.hh"
 #include "../Engine/Input.hh"
-#include "../Scenes/S13E01/Scene.hh"
-#include "../Scenes/S13E02/Scene.hh"
-#include "../Scenes/NavigateCube/Scene.hh"
+#include "../Engine/Trace.hh"
+#include "../Scenes/Registry.hh"
 
 #pragma mark - AppDelegate
 #pragma region AppDelegate {
@@ -40,14 +41,20 @@
     MTKView *_view;
     int _currentScene;
     std::unique_ptr<Engine::Renderer> _renderer;
-    CFTimeInterval _startTime;
-    std::unique_ptr<Engine::Scene> _scenes[3];
+    Engine::SteadyClock _clock;
+    // Touched by the display link thread, and by initializeSceneWithIndex
+    // while the display link is stopped.
+    Engine::FrameTimer _frames;
+    std::unique_ptr<Engine::Scene> _scenes[std::size(Scenes::registry)];
 }
 
 static CVReturn DisplayLinkCallback(CVDisplayLinkRef displayLink, const CVTimeStamp *inNow, const CVTimeStamp *inOutputTime, CVOptionFlags flagsIn, CVOptionFlags *flagsOut, void *displayLinkContext)
 {
     ViewController *viewController = (__bridge ViewController *)displayLinkContext;
-    viewController->_scenes[viewController->_currentScene]->onIdle(CACurrentMediaTime());
+    Engine::Trace::setThreadName("CVDisplayLink");
+    TRACE_ZONE("Scene::onIdle");
+    const auto frame = viewController->_frames.tick(viewController->_clock.now());
+    viewController->_scenes[viewController->_currentScene]->onIdle(frame);
     return kCVReturnSuccess;
 }
 
@@ -68,6 +75,7 @@ static CVReturn DisplayLinkCallback(CVDisplayLinkRef displayLink, const CVTimeSt
 
 - (void)mouseDown:(NSEvent *)event
 {
+    TRACE_ZONE("Scene::onMouseClicked");
     _scenes[_currentScene]->onMouseClicked(
                                            Engine::Input::MouseButton::Left,
                                            Engine::Input::ButtonState::Down,
@@ -76,6 +84,7 @@ static CVReturn DisplayLinkCallback(CVDisplayLinkRef displayLink, const CVTimeSt
 
 - (void)mouseUp:(NSEvent *)event
 {
+    TRACE_ZONE("Scene::onMouseClicked");
     _scenes[_currentScene]->onMouseClicked(
                                            Engine::Input::MouseButton::Left,
                                            Engine::Input::ButtonState::Up,
@@ -85,11 +94,17 @@ static CVReturn DisplayLinkCallback(CVDisplayLinkRef displayLink, const CVTimeSt
 // TODO: Use mouseMoved: instead
 - (void)mouseDragged:(NSEvent *)event
 {
+    TRACE_ZONE("Scene::onMouseMoved");
     _scenes[_currentScene]->onMouseMoved(simd::float2{(float)event.locationInWindow.x, (float)event.locationInWindow.y});
 }
 
 - (void)keyDown:(NSEvent *)event
 {
+    if ((Engine::Input::KeyboardButton)event.keyCode == Engine::Input::KeyboardButton::F12) {
+        [self toggleTrace];
+        return;
+    }
+    TRACE_ZONE("Scene::onKey");
     BOOL handled = NO;
     handled = _scenes[_currentScene]->onKey((Engine::Input::KeyboardButton)event.keyCode, Engine::Input::ButtonState::Down);
     if (!handled) {
@@ -97,6 +112,24 @@ static CVReturn DisplayLinkCallback(CVDisplayLinkRef displayLink, const CVTimeSt
     }
 }
 
+// F12 starts recording a trace, pressing it again writes it to the temporary
+// directory for chrome://tracing or ui.perfetto.dev.
+- (void)toggleTrace
+{
+    if (!Engine::Trace::enabled()) {
+        Engine::Trace::start();
+        NSLog(@"Tracing started");
+        return;
+    }
+    Engine::Trace::stop();
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"daedalus-trace.json"];
+    if (Engine::Trace::write(path.fileSystemRepresentation)) {
+        NSLog(@"Trace written to %@", path);
+    } else {
+        NSLog(@"Failed to write trace to %@", path);
+    }
+}
+
 - (void)sceneSelected:(NSMenuItem *)sender
 {
     NSMenu *scenesMenu = [sender menu];
@@ -111,13 +144,17 @@ static CVReturn DisplayLinkCallback(CVDisplayLinkRef displayLink, const CVTimeSt
 
 - (void)initializeSceneWithIndex:(int)index
 {
+    // onInit must not run alongside onIdle on the display link thread.
+    if (_displayLink) {
+        CVDisplayLinkStop(_displayLink);
+    }
     auto view = (__bridge MTK::View*)_view;
     if (_renderer != nullptr) {
         view->setDelegate(nullptr);
         _renderer.reset(nullptr);
     }
     _currentScene = index;
-    _scenes[_currentScene]->onInit(CACurrentMediaTime());
+    _scenes[_currentScene]->onInit(_frames.start(_clock.now()));
     auto *renderer = _scenes[_currentScene]->createRenderer((__bridge MTK::View*)_view);
     NSAssert(renderer, @"Renderer failed initialization");
     _renderer.reset(renderer);
@@ -125,12 +162,16 @@ static CVReturn DisplayLinkCallback(CVDisplayLinkRef displayLink, const CVTimeSt
     // Initialize our renderer with the view size
     _renderer->drawableSizeWillChange(view, view->drawableSize());
     view->setDelegate(_renderer.get());
+    if (_displayLink) {
+        CVDisplayLinkStart(_displayLink);
+    }
 }
 
 - (void)viewDidLoad
 {
     [super viewDidLoad];
     _view = (MTKView *)self.view;
+    Engine::Trace::setThreadName("Main");
     
     // Set up graphics device
     _view.device = MTLCreateSystemDefaultDevice();
@@ -141,14 +182,10 @@ static CVReturn DisplayLinkCallback(CVDisplayLinkRef displayLink, const CVTimeSt
     NSMenu *applicationMenu = [[NSApplication sharedApplication] mainMenu];
     NSMenu *scenesMenu = [[applicationMenu itemWithTitle:@"Scenes"] submenu];
     
-    _scenes[0] = std::make_unique<Scenes::S13E01::Scene>();
-    _scenes[1] = std::make_unique<Scenes::S13E02::Scene>();
-    _scenes[2] = std::make_unique<Scenes::NavigateCube::Scene>();
-    
-    NSArray *options = @[@"S13E01", @"S13E02", @"NavigateCube"];
-
-    for (NSString *option in options) {
-        NSMenuItem *menuItem = [[NSMenuItem alloc] initWithTitle:option action:@selector(sceneSelected:) keyEquivalent:@""];
+    for (size_t i = 0; i < std::size(Scenes::registry); ++i) {
+        _scenes[i] = Scenes::registry[i].make();
+        NSString *title = [NSString stringWithUTF8String:Scenes::registry[i].name];
+        NSMenuItem *menuItem = [[NSMenuItem alloc] initWithTitle:title action:@selector(sceneSelected:) keyEquivalent:@""];
         [scenesMenu addItem:menuItem];
     }
     // Set up scenes
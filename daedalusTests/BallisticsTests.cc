@@ -0,0 +1,42 @@
+#include <simd/simd.h>
+#include <cmath>
+#include <limits>
+
+#include "../daedalus/Scenes/S13E01/Ballistics.hh"
+#include "./Check.hh"
+
+using namespace Scenes::S13E01;
+
+namespace {
+
+constexpr float Infinity = std::numeric_limits<float>::infinity();
+const simd::float2 Radii{30, 60};
+
+} /* namespace */
+
+// A body flying level into one hovering in place touches it when their
+// centers are two radii apart.
+TEST(ImpactFindsFirstContact) {
+    const Parabola path{{0, 300}, {100, 0}, {0, 0}};
+    const Hover still{{500, 300}, {0, 0}, 0.5};
+    const auto hit = impact(path, still, 0, Radii, 0, 10);
+    CHECK(hit.has_value());
+    CHECK_NEAR(hit.value_or(-1), (500 - 2 * Radii.x) / 100, 1e-3);
+    CHECK(!impact(path, still, 0, Radii, 0, 4).has_value());
+}
+
+// Intervals the search cannot walk: an unbounded one, as exitTime gives for
+// a path that never leaves the screen, and one so far out that a step does
+// not change t. Both must return instead of spinning.
+TEST(ImpactGivesUpOnEndlessIntervals) {
+    const Parabola away{{0, 300}, {0, 100}, {0, 0}};
+    const Hover still{{500, 300}, {0, 0}, 0.5};
+    const float exit = exitTime(away, {-60, -120}, {660, Infinity});
+    CHECK(std::isinf(exit));
+    CHECK(!impact(away, still, 0, Radii, 0, exit).has_value());
+    CHECK(!impact(away, still, 0, Radii, -Infinity, 10).has_value());
+
+    const Parabola resting{{0, 300}, {0, 0}, {0, 0}};
+    const Hover bobbing{{500, 300}, {0, 210}, 0.5};
+    CHECK(!impact(resting, bobbing, 0, Radii, 1e9f, 2e9f).has_value());
+}
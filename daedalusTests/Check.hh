@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <vector>
+
+// Registration and assertions of the portable tests, see Tests.cc. A test
+// is a function declared with TEST(name); CHECKs that fail are reported with
+// their location and fail the run, the test carrying on. Benchmarks are
+// declared with BENCHMARK(name) and only run when asked for.
+namespace Tests {
+
+struct Case {
+    const char* name;
+    void (*run)();
+    bool benchmark;
+};
+
+inline std::vector<Case>& cases() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+// Checks may fail on any thread.
+inline std::atomic<int>& failures() {
+    static std::atomic<int> failures = 0;
+    return failures;
+}
+
+struct Registration {
+    Registration(const char* name, void (*run)(), bool benchmark) {
+        cases().push_back(Case{name, run, benchmark});
+    }
+};
+
+inline void fail(const char* file, int line, const char* expression) {
+    std::fprintf(stderr, "%s:%d: failed: %s\n", file, line, expression);
+    failures()++;
+}
+
+inline void failNear(const char* file, int line, const char* expression, double a, double b, double tolerance) {
+    std::fprintf(stderr, "%s:%d: failed: %s (%.9g vs %.9g, tolerance %.3g)\n", file, line, expression, a, b, tolerance);
+    failures()++;
+}
+
+inline void failWith(const char* file, int line, const char* format, ...) {
+    std::fprintf(stderr, "%s:%d: failed: ", file, line);
+    va_list arguments;
+    va_start(arguments, format);
+    std::vfprintf(stderr, format, arguments);
+    va_end(arguments);
+    std::fputc('\n', stderr);
+    failures()++;
+}
+
+// Calls f iterations times and reports the time per call; what f returns is
+// kept alive so the work is not optimized away.
+template <class F>
+void measure(const char* name, size_t iterations, F&& f) {
+    volatile double sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        sink = sink + double(f());
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%-40s %12.1f ns\n", name, elapsed.count() / iterations);
+}
+
+} /* namespace Tests */
+
+#define TESTS_CASE(name, benchmark) \
+    static void name(); \
+    static const Tests::Registration name##Registration(#name, name, benchmark); \
+    static void name()
+
+#define TEST(name) TESTS_CASE(name, false)
+#define BENCHMARK(name) TESTS_CASE(name, true)
+
+#define CHECK(expression) \
+    ((expression) ? (void)0 : Tests::fail(__FILE__, __LINE__, #expression))
+
+// Fails unconditionally, with a printf style message.
+#define FAIL(...) Tests::failWith(__FILE__, __LINE__, __VA_ARGS__)
+
+#define CHECK_NEAR(a, b, tolerance) \
+    (std::abs(double(a) - double(b)) <= double(tolerance) ? (void)0 : \
+        Tests::failNear(__FILE__, __LINE__, #a " ~ " #b, double(a), double(b), double(tolerance)))
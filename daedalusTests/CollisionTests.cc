@@ -0,0 +1,172 @@
+#include <simd/simd.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numbers>
+#include <random>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "../daedalus/Utility/Collision.hh"
+#include "./Check.hh"
+
+using Collision::Ellipse;
+
+namespace {
+
+constexpr int Pairs = 20000;
+constexpr int Samples = 2000;
+
+// The implicit function of e, below 1 inside it.
+double implicit(const Ellipse& e, double x, double y) {
+    const double dx = x - e.center.x, dy = y - e.center.y;
+    const double u = (dx * e.axis.x + dy * e.axis.y) / e.radii.x;
+    const double v = (-dx * e.axis.y + dy * e.axis.x) / e.radii.y;
+    return u * u + v * v;
+}
+
+// The smallest value either ellipse's implicit function takes on the other
+// one's boundary, sampled. At most 1 when the boundaries meet.
+double boundaryDistance(const Ellipse& a, const Ellipse& b) {
+    static const auto circle = [] {
+        std::vector<std::pair<double, double>> circle(Samples);
+        for (int i = 0; i < Samples; ++i) {
+            const double angle = 2 * std::numbers::pi * i / Samples;
+            circle[i] = {std::cos(angle), std::sin(angle)};
+        }
+        return circle;
+    }();
+    double smallest = INFINITY;
+    for (const auto& [cosine, sine] : circle) {
+        for (const auto& [e, other] : {std::pair{&a, &b}, std::pair{&b, &a}}) {
+            const double x = e->radii.x * cosine, y = e->radii.y * sine;
+            smallest = std::min(smallest, implicit(*other,
+                                                   e->center.x + x * e->axis.x - y * e->axis.y,
+                                                   e->center.y + x * e->axis.y + y * e->axis.x));
+        }
+    }
+    return smallest;
+}
+
+struct RandomEllipses {
+    std::mt19937 random;
+    std::uniform_real_distribution<float> position{-8, 8}, radius{0.2f, 5}, angle{0, 2 * std::numbers::pi_v<float>};
+
+    explicit RandomEllipses(uint32_t seed) : random(seed) {}
+
+    Ellipse operator()() {
+        const float t = angle(random);
+        return Ellipse{{position(random), position(random)}, {radius(random), radius(random)}, {std::cos(t), std::sin(t)}};
+    }
+};
+
+} /* namespace */
+
+// overlap() against sampled boundaries and centers, on random pairs of
+// any size, shape and orientation. Pairs within sampling error of touching
+// are left out.
+TEST(CollisionOverlapMatchesSampling) {
+    RandomEllipses ellipse(7);
+    int wrong = 0, ambiguous = 0;
+    for (int k = 0; k < Pairs; ++k) {
+        const auto a = ellipse(), b = ellipse();
+        const double distance = boundaryDistance(a, b);
+        if (std::abs(distance - 1) < 1e-2) {
+            ambiguous++;
+            continue;
+        }
+        const bool expected = distance <= 1 ||
+            implicit(b, a.center.x, a.center.y) <= 1 ||
+            implicit(a, b.center.x, b.center.y) <= 1;
+        wrong += Collision::overlap(a, b) != expected;
+    }
+    CHECK(wrong == 0);
+    CHECK(ambiguous < Pairs / 100);
+}
+
+// contact() agrees with overlap(), and moving a by the depth along the
+// normal, plus a little for rounding, separates the two.
+TEST(CollisionContactSeparates) {
+    RandomEllipses ellipse(11);
+    int disagreements = 0, stillOverlapping = 0, overlapping = 0;
+    for (int k = 0; k < Pairs; ++k) {
+        const auto a = ellipse(), b = ellipse();
+        const bool overlap = Collision::overlap(a, b);
+        const auto contact = Collision::contact(a, b);
+        disagreements += contact.overlap != overlap;
+        if (!overlap) {
+            CHECK(contact.depth == 0);
+            continue;
+        }
+        overlapping++;
+        CHECK_NEAR(simd::length(contact.normal), 1, 1e-5);
+        auto moved = a;
+        moved.center += contact.normal * (contact.depth * 1.0001f + 1e-4f);
+        stillOverlapping += Collision::overlap(moved, b);
+    }
+    CHECK(disagreements == 0);
+    CHECK(stillOverlapping == 0);
+    CHECK(overlapping > Pairs / 10);
+}
+
+// Touching counts as overlapping, also for the birds of S13E01: equal
+// axis-aligned ellipses whose centers are twice a radius apart.
+TEST(CollisionTouching) {
+    const simd::float2 radii{30, 60};
+    const Ellipse a{{0, 0}, radii};
+    CHECK(Collision::overlap(a, Ellipse{{60, 0}, radii}));
+    CHECK(Collision::overlap(a, Ellipse{{0, 119.9f}, radii}));
+    CHECK(!Collision::overlap(a, Ellipse{{60.1f, 0}, radii}));
+    CHECK(!Collision::overlap(a, Ellipse{{43, 86}, radii}));
+    CHECK(Collision::overlap(a, Ellipse{{42, 84}, radii}));
+    // Containment, both ways.
+    CHECK(Collision::overlap(a, Ellipse{{1, 2}, radii * 0.1f}));
+    CHECK(Collision::overlap(Ellipse{{1, 2}, radii * 0.1f}, a));
+}
+
+// The batch version gives what overlap() gives pair by pair, including the
+// lanes of a partial last group.
+TEST(CollisionBatchMatchesScalar) {
+    RandomEllipses ellipse(3);
+    std::vector<Ellipse> others(1003);
+    for (auto& other : others) {
+        other = ellipse();
+    }
+    const auto result = std::make_unique<bool[]>(others.size());
+    for (int k = 0; k < 20; ++k) {
+        const auto a = ellipse();
+        const size_t count = Collision::overlap(a, others, std::span<bool>(result.get(), others.size()));
+        size_t expected = 0, disagreements = 0;
+        for (size_t i = 0; i < others.size(); ++i) {
+            const bool overlap = Collision::overlap(a, others[i]);
+            expected += overlap;
+            disagreements += overlap != result[i];
+        }
+        CHECK(disagreements == 0);
+        CHECK(count == expected);
+    }
+}
+
+BENCHMARK(CollisionOverlap) {
+    RandomEllipses ellipse(5);
+    std::vector<Ellipse> as(4096), bs(4096);
+    for (size_t i = 0; i < as.size(); ++i) {
+        as[i] = ellipse();
+        bs[i] = ellipse();
+    }
+    const auto result = std::make_unique<bool[]>(bs.size());
+    size_t i = 0;
+    Tests::measure("Collision::overlap per pair", 4000000, [&] {
+        i = (i + 1) % as.size();
+        return Collision::overlap(as[i], bs[i]);
+    });
+    Tests::measure("Collision::overlap batch of 4096", 1000, [&] {
+        i = (i + 1) % as.size();
+        return Collision::overlap(as[i], bs, std::span<bool>(result.get(), bs.size()));
+    });
+    Tests::measure("Collision::contact per pair", 400000, [&] {
+        i = (i + 1) % as.size();
+        return Collision::contact(as[i], bs[i]).depth;
+    });
+}
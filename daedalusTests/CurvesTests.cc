@@ -0,0 +1,315 @@
+#include <simd/simd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "../daedalus/Scenes/S13E02/Curves.hh"
+#include "./Check.hh"
+
+using namespace Scenes::S13E02;
+
+namespace {
+
+Bezier randomBezier(std::mt19937& random, int count) {
+    std::uniform_real_distribution<float> coordinate(0, 600);
+    Bezier curve{};
+    for (auto i = 0; i < count; ++i) {
+        curve.addControlPoint(simd::float2{coordinate(random), coordinate(random)});
+    }
+    return curve;
+}
+
+} /* namespace */
+
+// Forward differencing against the Bernstein matrix product, at every degree
+// the difference table covers and across several reseeds.
+TEST(BezierTessellateMatchesEvaluate) {
+    std::mt19937 random(13);
+    for (auto count = 2; count <= int(Bezier::N); ++count) {
+        const auto curve = randomBezier(random, count);
+        for (const size_t n : {size_t(1), size_t(7), size_t(500), size_t(4096)}) {
+            std::vector<float> ts(n);
+            for (size_t i = 0; i < n; ++i) {
+                ts[i] = (float)i / n;
+            }
+            std::vector<simd::float2> expected(n), actual(n);
+            curve.evaluate(ts, expected);
+            curve.tessellate(actual);
+            float error = 0;
+            for (size_t i = 0; i < n; ++i) {
+                error = std::max(error, simd::length(actual[i] - expected[i]));
+            }
+            CHECK_NEAR(error, 0, 1e-2);
+        }
+    }
+}
+
+// evaluate() itself against the scalar Horner form, including the high
+// degrees that both hand to bernstein().
+TEST(BezierEvaluateMatchesPointwise) {
+    std::mt19937 random(6);
+    for (const int count : {1, 2, 5, int(Bezier::N), 40}) {
+        const auto curve = randomBezier(random, count);
+        std::vector<float> ts(37);
+        for (size_t i = 0; i < ts.size(); ++i) {
+            ts[i] = (float)i / (ts.size() - 1);
+        }
+        std::vector<simd::float2> out(ts.size());
+        curve.evaluate(ts, out);
+        for (size_t i = 0; i < ts.size(); ++i) {
+            CHECK_NEAR(simd::length(out[i] - curve(ts[i])), 0, 1e-2);
+        }
+    }
+}
+
+namespace {
+
+// Largest distance from the curve, sampled densely, to the strip.
+float distanceToStrip(const Bezier& curve, std::span<const simd::float2> strip) {
+    float largest = 0;
+    for (auto k = 0; k <= 2000; ++k) {
+        const simd::float2 p = curve(k / 2000.0f);
+        float nearest = INFINITY;
+        for (size_t i = 0; i + 1 < strip.size(); ++i) {
+            const simd::float2 chord = strip[i+1] - strip[i];
+            const float len2 = simd::dot(chord, chord);
+            const float along = len2 > 0 ? std::clamp(simd::dot(p - strip[i], chord) / len2, 0.0f, 1.0f) : 0;
+            nearest = std::min(nearest, simd::length(p - (strip[i] + chord * along)));
+        }
+        largest = std::max(largest, nearest);
+    }
+    return largest;
+}
+
+} /* namespace */
+
+// The flattened strip stays within tolerance of the curve, also when the
+// control points are in line but overshoot the ends of the chord, so that
+// every control polygon lies on the line through its chord.
+TEST(BezierFlattenStaysWithinTolerance) {
+    constexpr float Tolerance = 0.25f;
+    std::vector<Bezier> curves;
+    for (const auto& points : std::vector<std::vector<simd::float2>>{
+        {{0, 0}, {300, 0}, {-200, 0}, {100, 0}},
+        {{0, 0}, {400, 400}, {100, 100}},
+        {{50, 50}, {-100, 50}, {300, 50}, {-100, 50}, {60, 50}},
+    }) {
+        Bezier curve{};
+        curve.addControlPoints(points);
+        curves.push_back(curve);
+    }
+    std::mt19937 random(12);
+    for (auto count = 2; count <= int(Bezier::N); ++count) {
+        curves.push_back(randomBezier(random, count));
+    }
+    std::vector<simd::float2> strip(4096);
+    for (const auto& curve : curves) {
+        const size_t n = curve.flatten(strip, Tolerance, matrix_identity_float4x4);
+        CHECK(n >= 2 && n < strip.size());
+        CHECK(strip[n - 1].x == curve.point(curve.size() - 1).x && strip[n - 1].y == curve.point(curve.size() - 1).y);
+        CHECK_NEAR(distanceToStrip(curve, std::span(strip.data(), n)), 0, Tolerance * 1.01f);
+    }
+}
+
+BENCHMARK(BezierTessellate) {
+    std::mt19937 random(1);
+    const auto curve = randomBezier(random, Bezier::N);
+    std::vector<float> ts(500);
+    for (size_t i = 0; i < ts.size(); ++i) {
+        ts[i] = (float)i / ts.size();
+    }
+    std::vector<simd::float2> out(ts.size());
+    Tests::measure("Bezier::tessellate 500 samples", 20000, [&] {
+        curve.tessellate(out);
+        return out[ts.size() / 2].x;
+    });
+    Tests::measure("Bezier::evaluate 500 samples", 20000, [&] {
+        curve.evaluate(ts, out);
+        return out[ts.size() / 2].x;
+    });
+}
+
+namespace {
+
+TCR randomTCR(std::mt19937& random, int count) {
+    std::uniform_real_distribution<float> coordinate(0, 600);
+    std::uniform_real_distribution<float> interval(0.1f, 1.5f);
+    TCR curve{};
+    float t = 0;
+    for (auto i = 0; i < count; ++i) {
+        curve.addControlPoint(simd::float2{coordinate(random), coordinate(random)}, t);
+        t += interval(random);
+    }
+    return curve;
+}
+
+// Length of the polyline through f at n even steps over [a, b], which
+// approaches the arc length from below as n grows.
+template <class F>
+double polylineLength(const F& f, float a, float b, int n) {
+    double length = 0;
+    simd::float2 previous = f(a);
+    for (auto i = 1; i <= n; ++i) {
+        const simd::float2 next = f(a + (b - a) * (float)((double)i / n));
+        length += simd::length(next - previous);
+        previous = next;
+    }
+    return length;
+}
+
+} /* namespace */
+
+// The cursor finds the segment index() finds, walking forward, jumping
+// ahead several segments, going backwards, and after the curve it was used
+// with is replaced by a shorter one.
+TEST(TCRCursorMatchesIndex) {
+    std::mt19937 random(4);
+    for (const int count : {0, 1, 2, 3, 12, 40}) {
+        const auto curve = randomTCR(random, count);
+        const float begin = count ? curve.t[0] : 0, end = count ? curve.t[count - 1] : 1;
+        std::uniform_real_distribution<float> step(0, (end - begin) / 8), anywhere(begin - 1, end + 1);
+        TCR::Cursor cursor;
+        int wrong = 0;
+        for (float tx = begin - 0.5f; tx < end + 0.5f; tx += step(random) + 1e-3f) {
+            const int i = cursor.seek(curve, tx);
+            wrong += i != curve.index(tx);
+            if (count > 1) {
+                wrong += simd::length(curve(tx, i) - curve(tx)) != 0;
+                const auto w = curve.weight(tx, i), expected = curve.weight(tx);
+                for (int j = 0; j < 4; ++j) {
+                    wrong += w[j] != expected[j];
+                }
+            }
+        }
+        for (int k = 0; k < 200; ++k) {
+            const float tx = anywhere(random);
+            wrong += cursor.seek(curve, tx) != curve.index(tx);
+        }
+        const auto shorter = randomTCR(random, std::min(count, 2));
+        wrong += cursor.seek(shorter, end) != shorter.index(end);
+        CHECK(wrong == 0);
+    }
+}
+
+// Gauss-Legendre lengths against dense polylines, from the start to points
+// inside segments and to the end. Five nodes per interval leave errors of
+// about 0.1% on segments that turn sharply, hence the 0.5% allowed.
+TEST(TCRLengthAtMatchesPolyline) {
+    std::mt19937 random(8);
+    for (const int count : {2, 3, 6, 12}) {
+        const auto curve = randomTCR(random, count);
+        auto at = [&](float tx) {
+            const int i = curve.index(tx);
+            return curve.segments[i](tx - curve.t[i]);
+        };
+        const float begin = curve.t[0], end = curve.t[count - 1];
+        for (const float fraction : {0.0f, 0.13f, 0.5f, 0.77f, 1.0f}) {
+            const float tx = begin + (end - begin) * fraction;
+            const double expected = polylineLength(at, begin, tx, 20000);
+            CHECK_NEAR(curve.lengthAt(tx), expected, 5e-3 * std::max(expected, 1.0));
+        }
+        CHECK_NEAR(curve.lengthAt(end), curve.length(), 1e-3 * curve.length());
+        CHECK(curve.lengthAt(begin - 1) == 0);
+    }
+}
+
+TEST(BezierLengthAtMatchesPolyline) {
+    std::mt19937 random(9);
+    for (const int count : {2, 3, 5, int(Bezier::N), 30}) {
+        const auto curve = randomBezier(random, count);
+        for (const float t : {0.0f, 0.21f, 0.5f, 0.9f, 1.0f}) {
+            const double expected = polylineLength(curve, 0, t, 20000);
+            CHECK_NEAR(curve.lengthAt(t), expected, 5e-3 * std::max(expected, 1.0));
+        }
+        CHECK_NEAR(curve.lengthAt(1), curve.length(), 1e-3 * curve.length());
+    }
+}
+
+// Segment lookups for the samples of a sweep along a long curve.
+BENCHMARK(TCRSegmentLookup) {
+    std::mt19937 random(2);
+    const auto curve = randomTCR(random, 200);
+    const float begin = curve.t[0], end = curve.t[curve.size() - 1];
+    constexpr int Samples = 4096;
+    Tests::measure("TCR::index 4096 increasing", 2000, [&] {
+        int sum = 0;
+        for (int k = 0; k < Samples; ++k) {
+            sum += curve.index(begin + (end - begin) * k / Samples);
+        }
+        return sum;
+    });
+    Tests::measure("TCR::Cursor 4096 increasing", 2000, [&] {
+        TCR::Cursor cursor;
+        int sum = 0;
+        for (int k = 0; k < Samples; ++k) {
+            sum += cursor.seek(curve, begin + (end - begin) * k / Samples);
+        }
+        return sum;
+    });
+}
+
+namespace {
+
+simd::float4x4 scaled(float s) {
+    auto m = matrix_identity_float4x4;
+    m.columns[0].x = m.columns[1].y = s;
+    return m;
+}
+
+} /* namespace */
+
+// A camera change redoes an adaptive tessellation, which depends on it, but
+// keeps a uniform one. Appends redo only the last two TCR segments.
+TEST(TessellationCacheKeepsWhatStillHolds) {
+    std::mt19937 random(5);
+    auto curve = randomTCR(random, 6);
+    for (const auto mode : {TessellationMode::Uniform, TessellationMode::Adaptive}) {
+        TessellationCache cache;
+        const auto strip = cache.update(curve, TessellationParams{mode, 0.25f, scaled(1)});
+        CHECK(cache.counters.updates == 1 && cache.counters.segments == 5);
+        const auto first = strip.front(), last = strip.back();
+        CHECK(first.x == curve.point(0).x && last.x == curve.point(5).x && last.y == curve.point(5).y);
+        
+        cache.update(curve, TessellationParams{mode, 0.25f, scaled(1)});
+        CHECK(cache.counters.updates == 1);
+        cache.update(curve, TessellationParams{mode, 0.5f, scaled(3)});
+        CHECK(cache.counters.updates == (mode == TessellationMode::Uniform ? 1 : 2));
+    }
+    
+    TessellationCache cache;
+    const TessellationParams params{TessellationMode::Adaptive, 0.25f, scaled(1)};
+    cache.update(curve, params);
+    curve.addControlPoint(simd::float2{10, 20}, curve.t[5] + 1);
+    const auto strip = cache.update(curve, params);
+    CHECK(cache.counters.updates == 2 && cache.counters.segments == 5 + 2);
+    CHECK(cache.offsets.size() == 7 && cache.offsets.back() == strip.size());
+    CHECK(strip.back().x == 10 && strip.back().y == 20);
+}
+
+BENCHMARK(TessellationCacheAppend) {
+    std::mt19937 random(3);
+    const auto base = randomTCR(random, 9);
+    const TessellationParams params{TessellationMode::Adaptive, 0.25f, scaled(6)};
+    TessellationCache cache;
+    cache.update(base, params);
+    Tests::measure("TessellationCache TCR append, adaptive", 20000, [&] {
+        auto curve = base;
+        curve.addControlPoint(simd::float2{300, 300}, curve.t[8] + 1);
+        return cache.update(curve, params).size();
+    });
+}
+
+// parameterAt inverts lengthAt.
+TEST(LengthAtRoundTrips) {
+    std::mt19937 random(10);
+    const auto tcr = randomTCR(random, 8);
+    const auto bezier = randomBezier(random, 6);
+    for (const float fraction : {0.05f, 0.3f, 0.62f, 0.95f}) {
+        const float tx = tcr.t[0] + (tcr.t[7] - tcr.t[0]) * fraction;
+        CHECK_NEAR(tcr.parameterAt(tcr.lengthAt(tx)), tx, 1e-3);
+        CHECK_NEAR(bezier.parameterAt(bezier.lengthAt(fraction)), fraction, 1e-3);
+    }
+}
@@ -0,0 +1,52 @@
+#include <cstdint>
+#include <vector>
+
+#include "../daedalus/Engine/FixedStep.hh"
+#include "./Check.hh"
+
+namespace {
+
+constexpr Engine::Ticks Step = 10;
+
+} /* namespace */
+
+// Whole steps come out of the accumulated time in order, starting where the
+// last one ended; the rest is left as alpha.
+TEST(FixedStepTakesWholeSteps) {
+    Engine::FixedStep fixed(Step, 8);
+    fixed.reset(1000);
+    std::vector<Engine::Ticks> starts;
+    auto record = [&](Engine::Ticks t) { starts.push_back(t); };
+
+    CHECK(fixed.advance(4, record) == 0);
+    CHECK_NEAR(fixed.alpha(), 0.4, 1e-6);
+    CHECK(fixed.advance(17, record) == 2);
+    CHECK(fixed.advance(-50, record) == 0);
+    CHECK(fixed.advance(9, record) == 1);
+    CHECK(starts == (std::vector<Engine::Ticks>{1000, 1010, 1020}));
+    CHECK(fixed.time() == 1030);
+    CHECK_NEAR(fixed.alpha(), 0, 1e-6);
+    CHECK(fixed.stats().steps == 3 && fixed.stats().clampedFrames == 0);
+}
+
+// A frame longer than maxSteps steps runs maxSteps of them and drops the
+// rest, so the simulation falls behind the frames instead of piling up work.
+TEST(FixedStepClampsLongFrames) {
+    Engine::FixedStep fixed(Step, 4);
+    fixed.reset(0);
+    unsigned steps = 0;
+    auto count = [&](Engine::Ticks) { steps++; };
+
+    CHECK(fixed.advance(Step * 100 + 3, count) == 4);
+    CHECK(fixed.time() == Step * 4);
+    CHECK_NEAR(fixed.alpha(), 0, 1e-6);
+    CHECK(fixed.stats().clampedFrames == 1 && fixed.stats().dropped == Step * 96 + 3);
+
+    CHECK(fixed.advance(Step * 4, count) == 4);
+    CHECK(fixed.stats().clampedFrames == 1);
+    CHECK(steps == 8);
+
+    fixed.reset(500);
+    CHECK(fixed.advance(Step - 1, count) == 0);
+    CHECK(fixed.time() == 500);
+}
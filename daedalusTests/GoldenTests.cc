@@ -0,0 +1,107 @@
+#include <simd/simd.h>
+#include <cstdlib>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "../daedalus/Headless/Golden.hh"
+#include "../daedalus/Headless/Harness.hh"
+#include "../daedalus/Scenes/Registry.hh"
+#include "./Check.hh"
+
+// Scripted runs of the scenes, drawn by the software rasterizer at a
+// reduced size and compared with the images in Goldens. A frame that does
+// not match leaves its image and a heatmap of the difference in the
+// temporary directory, under daedalus-goldens.
+//
+// To record goldens, delete the stale ones and run the tests with
+// DAEDALUS_RECORD_GOLDENS set. Paths are relative to this file as compiled,
+// so the build command in Tests.cc must be run from the repository root.
+namespace {
+
+using Headless::InputEvent;
+
+constexpr uint32_t Size = 200;
+// Scenes evaluate in float, so compilers and SIMD backends may move a few
+// edge pixels.
+const Headless::Tolerance tolerance{2, 100};
+
+InputEvent click(uint64_t frame, simd::float2 position, Engine::Input::ButtonState state) {
+    auto event = InputEvent{frame, InputEvent::Type::MouseClick, position};
+    event.state = state;
+    return event;
+}
+
+InputEvent key(uint64_t frame, Engine::Input::KeyboardButton button) {
+    auto event = InputEvent{frame, InputEvent::Type::Key};
+    event.key = button;
+    return event;
+}
+
+void checkScene(const char* name, std::span<const InputEvent> script, std::span<const Headless::GoldenFrame> frames) {
+    const auto registration = Scenes::find(name);
+    CHECK(registration && registration->program);
+    if (!registration || !registration->program) {
+        return;
+    }
+    const auto scene = registration->make();
+    Headless::Harness harness(*scene, *registration->program(), Size, Size, script);
+
+    const auto directory = std::filesystem::path(__FILE__).parent_path() / "Goldens";
+    const auto output = std::filesystem::temp_directory_path() / "daedalus-goldens";
+    const bool record = std::getenv("DAEDALUS_RECORD_GOLDENS") != nullptr;
+    Headless::checkGoldens(harness, frames, directory, output, tolerance, [&](const Headless::GoldenFrame& frame, const Headless::GoldenResult& result) {
+        switch (result.status) {
+            case Headless::GoldenResult::Status::Match:
+            case Headless::GoldenResult::Status::Recorded:
+                break;
+            case Headless::GoldenResult::Status::Missing:
+                FAIL("%s: no golden image in %s", frame.name, directory.c_str());
+                break;
+            case Headless::GoldenResult::Status::Mismatch:
+                FAIL("%s: %llu pixels differ, by up to %u, see %s", frame.name,
+                     (unsigned long long)result.diff.pixels, result.diff.maxDelta, output.c_str());
+                break;
+        }
+    }, record);
+}
+
+} /* namespace */
+
+// The red bird is pulled back and down and let go as the green one comes
+// down, so that the two collide and overlap.
+TEST(S13E01Goldens) {
+    using enum Engine::Input::ButtonState;
+    std::vector<InputEvent> script{click(50, {200, 200}, Down)};
+    for (uint64_t i = 1; i <= 8; ++i) {
+        const simd::float2 pulled{200 - 130 * i / 8.0f, 200 - 90 * i / 8.0f};
+        script.push_back(InputEvent{50 + i, InputEvent::Type::MouseMove, pulled});
+    }
+    script.push_back(click(59, {70, 110}, Up));
+
+    const Headless::GoldenFrame frames[] = {
+        {"S13E01-start", 0},
+        {"S13E01-drag", 58},
+        {"S13E01-flight", 68},
+        {"S13E01-hit", 100},
+    };
+    checkScene("S13E01", script, frames);
+}
+
+// Five control points, then the animation along them.
+TEST(S13E02Goldens) {
+    using enum Engine::Input::ButtonState;
+    const simd::float2 points[] = {{100, 150}, {220, 420}, {320, 260}, {430, 480}, {520, 200}};
+    std::vector<InputEvent> script;
+    for (uint64_t i = 0; i < std::size(points); ++i) {
+        script.push_back(click(10 + 10 * i, points[i], Down));
+        script.push_back(click(11 + 10 * i, points[i], Up));
+    }
+    script.push_back(key(70, Engine::Input::KeyboardButton::SPACEBAR));
+
+    const Headless::GoldenFrame frames[] = {
+        {"S13E02-edit", 60},
+        {"S13E02-animation", 100},
+    };
+    checkScene("S13E02", script, frames);
+}
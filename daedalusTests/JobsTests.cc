@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../daedalus/Engine/Jobs.hh"
+#include "./Check.hh"
+
+namespace {
+
+// Pools small enough that tasks contend for the threads, and one with no
+// workers at all that only runs tasks while something waits.
+constexpr unsigned PoolSizes[] = {1, 2, 4, 8};
+
+} /* namespace */
+
+// Every index is visited exactly once, whatever the grain and the pool.
+TEST(JobsParallelForCoversRange) {
+    for (const unsigned threads : PoolSizes) {
+        Engine::JobSystem jobs(threads);
+        for (const size_t count : {size_t(0), size_t(1), size_t(7), size_t(1000), size_t(100003)}) {
+            for (const size_t grain : {size_t(0), size_t(1), size_t(13), size_t(4096)}) {
+                std::vector<std::atomic<uint32_t>> visits(count + 2);
+                jobs.parallelFor(1, count + 1, grain, [&](size_t begin, size_t end) {
+                    CHECK(begin < end);
+                    CHECK(end - begin <= std::max<size_t>(grain, 1));
+                    for (size_t i = begin; i < end; ++i) {
+                        visits[i].fetch_add(1, std::memory_order_relaxed);
+                    }
+                });
+                size_t wrong = visits[0] + visits[count + 1];
+                for (size_t i = 1; i <= count; ++i) {
+                    wrong += visits[i] != 1;
+                }
+                CHECK(wrong == 0);
+            }
+        }
+    }
+}
+
+// Tasks that wait for tasks they submit, and parallelFor inside parallelFor,
+// on pools with fewer threads than there are waiters: a waiting thread has
+// to run the work it waits for.
+TEST(JobsNestedWaitFromJob) {
+    for (const unsigned threads : PoolSizes) {
+        Engine::JobSystem jobs(threads);
+
+        std::atomic<uint32_t> leaves = 0;
+        std::vector<Engine::Handle> outer;
+        for (int i = 0; i < 64; ++i) {
+            outer.push_back(jobs.run([&] {
+                std::vector<Engine::Handle> inner;
+                for (int j = 0; j < 16; ++j) {
+                    inner.push_back(jobs.run([&] {
+                        leaves.fetch_add(1, std::memory_order_relaxed);
+                    }));
+                }
+                for (const auto& handle : inner) {
+                    jobs.wait(handle);
+                    CHECK(handle.done());
+                }
+            }));
+        }
+        for (const auto& handle : outer) {
+            jobs.wait(handle);
+        }
+        CHECK(leaves == 64 * 16);
+
+        std::atomic<uint64_t> sum = 0;
+        jobs.parallelFor(0, 32, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                jobs.parallelFor(0, 1000, 10, [&](size_t b, size_t e) {
+                    uint64_t local = 0;
+                    for (size_t k = b; k < e; ++k) {
+                        local += k;
+                    }
+                    sum.fetch_add(local, std::memory_order_relaxed);
+                });
+            }
+        });
+        CHECK(sum == 32 * (999 * 1000 / 2));
+    }
+}
+
+// Chains of continuations built by several threads at once, while the
+// links before them are already running. Each link must see its
+// predecessor done and its effects.
+TEST(JobsThenChainsUnderContention) {
+    for (const unsigned threads : PoolSizes) {
+        Engine::JobSystem jobs(threads);
+        constexpr int Builders = 4, Chains = 16, Length = 64;
+
+        std::vector<std::unique_ptr<std::atomic<int>>> values;
+        for (int i = 0; i < Builders * Chains; ++i) {
+            values.push_back(std::make_unique<std::atomic<int>>(0));
+        }
+        std::vector<Engine::Handle> tails(Builders * Chains);
+        std::atomic<int> misordered = 0;
+
+        std::vector<std::thread> builders;
+        for (int b = 0; b < Builders; ++b) {
+            builders.emplace_back([&, b] {
+                for (int c = b * Chains; c < (b + 1) * Chains; ++c) {
+                    auto& value = *values[c];
+                    Engine::Handle tail = jobs.run([&value] { value.store(1, std::memory_order_relaxed); });
+                    for (int k = 2; k <= Length; ++k) {
+                        tail = jobs.then(tail, [&value, &misordered, k] {
+                            if (value.load(std::memory_order_relaxed) != k - 1) {
+                                misordered.fetch_add(1, std::memory_order_relaxed);
+                            }
+                            value.store(k, std::memory_order_relaxed);
+                        });
+                    }
+                    tails[c] = tail;
+                }
+            });
+        }
+        for (auto& builder : builders) {
+            builder.join();
+        }
+
+        // Fan in over all chains, plus an empty handle and a finished one.
+        const Engine::Handle finished = jobs.run([] {});
+        jobs.wait(finished);
+        tails.push_back(Engine::Handle{});
+        tails.push_back(finished);
+        std::atomic<int> total = 0;
+        const auto join = jobs.then(std::span<const Engine::Handle>(tails), [&] {
+            for (const auto& value : values) {
+                total.fetch_add(value->load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+        });
+        jobs.wait(join);
+
+        CHECK(misordered == 0);
+        CHECK(total == Builders * Chains * Length);
+        for (const auto& tail : tails) {
+            CHECK(tail.done());
+        }
+    }
+}
+
+// Whatever is still queued runs before the pool goes away.
+TEST(JobsDestructionDrainsQueue) {
+    std::atomic<int> ran = 0;
+    {
+        Engine::JobSystem jobs(1);
+        for (int i = 0; i < 100; ++i) {
+            jobs.run([&] { ran.fetch_add(1, std::memory_order_relaxed); });
+        }
+    }
+    CHECK(ran == 100);
+}
+
+// parallelFor over a compute-bound loop on pools of growing size, and the
+// overhead of an almost empty one.
+BENCHMARK(JobsParallelForScaling) {
+    constexpr size_t Count = 1 << 20;
+    std::vector<float> values(Count);
+    const unsigned hardware = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned threads = 1; threads <= hardware; threads *= 2) {
+        Engine::JobSystem jobs(threads);
+        char name[64];
+        std::snprintf(name, sizeof(name), "parallelFor 1M sqrt, %u threads", threads);
+        Tests::measure(name, 50, [&] {
+            jobs.parallelFor(0, Count, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    values[i] = std::sqrt(float(i) * 1.5f + values[i]);
+                }
+            });
+            return values[Count / 2];
+        });
+        std::snprintf(name, sizeof(name), "parallelFor 64 items, %u threads", threads);
+        Tests::measure(name, 10000, [&] {
+            jobs.parallelFor(0, 64, 1, [&](size_t begin, size_t end) {
+                values[begin] += float(end);
+            });
+            return values[0];
+        });
+    }
+}
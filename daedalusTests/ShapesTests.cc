@@ -0,0 +1,134 @@
+#include <simd/simd.h>
+#include <cstdint>
+#include <vector>
+
+#include "../daedalus/Engine/CommandList.hh"
+#include "../daedalus/Utility/ShapeRenderer.hh"
+#include "./Check.hh"
+
+namespace {
+
+const Shapes::Pipelines pipelines{1, 2};
+
+// A figure in the layout of the S13E01 birds: a triangle under its body,
+// the body, and a triangle over it.
+void figure(Shapes::Layer& layer, simd::float2 position, simd::float3 color) {
+    layer.triangle(position, position + simd::float2{-40, 20}, position + simd::float2{-40, -20}, color, Shapes::Layer::Depth::Under);
+    layer.ellipse(position, simd::float2{30, 60}, color);
+    layer.triangle(position, position + simd::float2{40, 5}, position + simd::float2{40, -5}, color);
+}
+
+} /* namespace */
+
+TEST(LayerSortsShapesByDepth) {
+    Shapes::Layer layer;
+    CHECK(layer.empty());
+    layer.triangle({0, 0}, {1, 0}, {0, 1}, {1, 0, 0}, Shapes::Layer::Depth::Under);
+    layer.ellipse({5, 6}, {2, 3}, {0, 1, 0}, {-1, 1});
+    layer.circle({7, 8}, 4, {0, 0, 1});
+    layer.triangle({0, 0}, {2, 0}, {0, 2}, {1, 1, 0});
+    CHECK(layer.under.size() == 1);
+    CHECK(layer.ellipses.size() == 2);
+    CHECK(layer.over.size() == 1);
+    CHECK(layer.ellipses[0].facing.x == -1);
+    CHECK(layer.ellipses[1].radii.x == 4 && layer.ellipses[1].radii.y == 4);
+    CHECK(layer.over[0].corners[1].x == 2);
+
+    const auto capacity = layer.ellipses.capacity();
+    layer.clear();
+    CHECK(layer.empty());
+    CHECK(layer.ellipses.capacity() == capacity);
+}
+
+TEST(LayerMeshIsUnitCircleStrip) {
+    const auto& mesh = Shapes::Layer::mesh();
+    CHECK(mesh.size() == 2 * Shapes::Layer::Resolution + 1);
+    for (size_t i = 0; i < mesh.size(); i += 2) {
+        CHECK_NEAR(simd::length(mesh[i]), 1, 1e-6);
+    }
+    for (size_t i = 1; i < mesh.size(); i += 2) {
+        CHECK(mesh[i].x == 0 && mesh[i].y == 0);
+    }
+}
+
+// One draw per list, under the ellipses, the ellipses, over them, and the
+// instances land in the arena as recorded.
+TEST(DrawRecordsLayerInDepthOrder) {
+    Shapes::Layer layer;
+    figure(layer, {100, 100}, {1, 0, 0});
+
+    Engine::CommandList commands;
+    Shapes::draw(commands, layer, pipelines);
+    const auto recorded = commands.commands();
+    CHECK(recorded.size() == 3);
+    CHECK(recorded[0].pipeline == pipelines.triangles && recorded[0].vertexCount == 3 && recorded[0].data.size == 0);
+    CHECK(recorded[1].pipeline == pipelines.ellipses && recorded[1].primitive == Engine::PrimitiveType::TriangleStrip);
+    CHECK(recorded[1].vertexCount == Shapes::Layer::mesh().size());
+    CHECK(recorded[2].pipeline == pipelines.triangles);
+
+    const auto under = commands.view<Shapes::TriangleInstance>(recorded[0].instances);
+    const auto ellipses = commands.view<Shapes::EllipseInstance>(recorded[1].instances);
+    const auto over = commands.view<Shapes::TriangleInstance>(recorded[2].instances);
+    CHECK(under.size() == 1 && under[0].corners[1].x == 60);
+    CHECK(ellipses.size() == 1 && ellipses[0].radii.y == 60);
+    CHECK(over.size() == 1 && over[0].corners[1].x == 140);
+    CHECK(commands.stats().instances == 3);
+}
+
+// Lists longer than a setVertexBytes call holds are split, in order.
+TEST(DrawSplitsLongLists) {
+    Shapes::Layer layer;
+    const size_t count = 1000;
+    for (size_t i = 0; i < count; ++i) {
+        layer.circle({float(i), 0}, 1, {1, 1, 1});
+    }
+    Engine::CommandList commands;
+    Shapes::draw(commands, layer, pipelines);
+
+    size_t next = 0;
+    for (const auto& command : commands.commands()) {
+        CHECK(command.instanceCount * sizeof(Shapes::EllipseInstance) <= 4000);
+        for (const auto& instance : commands.view<Shapes::EllipseInstance>(command.instances)) {
+            CHECK(instance.center.x == float(next));
+            next++;
+        }
+    }
+    CHECK(commands.commands().size() > 1);
+    CHECK(next == count);
+}
+
+// Overlapping figures in separate layers: everything of the first is drawn
+// before anything of the second, so the second covers the first's top
+// triangles instead of the other way round.
+TEST(LayersKeepFigureOrder) {
+    Shapes::Layer layers[2];
+    figure(layers[0], {100, 100}, {1, 0, 0});
+    figure(layers[1], {120, 100}, {0, 1, 0});
+
+    Engine::CommandList commands;
+    for (const auto& layer : layers) {
+        Shapes::draw(commands, layer, pipelines);
+    }
+    const auto recorded = commands.commands();
+    CHECK(recorded.size() == 6);
+    for (size_t i = 0; i < recorded.size(); ++i) {
+        const auto& command = recorded[i];
+        const float red = command.pipeline == pipelines.ellipses ?
+            commands.view<Shapes::EllipseInstance>(command.instances)[0].color.x :
+            commands.view<Shapes::TriangleInstance>(command.instances)[0].color.x;
+        CHECK(red == (i < 3 ? 1 : 0));
+    }
+}
+
+BENCHMARK(LayerBuildAndDraw) {
+    Shapes::Layer layer;
+    Engine::CommandList commands;
+    Tests::measure("Layer 2 figures build and draw", 1000000, [&] {
+        layer.clear();
+        commands.reset();
+        figure(layer, {100, 100}, {1, 0, 0});
+        figure(layer, {120, 100}, {0, 1, 0});
+        Shapes::draw(commands, layer, pipelines);
+        return commands.stats().instances;
+    });
+}
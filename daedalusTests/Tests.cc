@@ -0,0 +1,45 @@
+// Portable tests of the engine and the scenes, runnable without a window.
+//
+//     daedalus-tests              runs every test
+//     daedalus-tests Curves       runs the tests whose name contains Curves
+//     daedalus-tests --bench      runs the benchmarks instead
+//
+// Exits with 1 if any check failed. It needs no Apple frameworks. On Linux,
+// from the repository root:
+//
+//     c++ -std=c++20 -O2 -pthread -I daedalus/Portable -o daedalus-tests
+//         daedalusTests/*.cc daedalus/Headless/NoRenderer.cc
+//         daedalus/Scenes/*/Scene.cc
+//
+// and run it from there too, the golden images are found relative to it.
+
+#include <cstdio>
+#include <cstring>
+
+#include "./Check.hh"
+
+int main(int argc, char** argv) {
+    bool benchmarks = false;
+    const char* filter = "";
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--bench") == 0) {
+            benchmarks = true;
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    int run = 0;
+    for (const auto& test : Tests::cases()) {
+        if (test.benchmark != benchmarks || !std::strstr(test.name, filter)) {
+            continue;
+        }
+        const int before = Tests::failures();
+        test.run();
+        std::printf("%s %s\n", Tests::failures() == before ? "ok  " : "FAIL", test.name);
+        run++;
+    }
+
+    std::printf("%d run, %d failed checks\n", run, Tests::failures().load());
+    return Tests::failures() ? 1 : 0;
+}
@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "../daedalus/Engine/UploadRing.hh"
+#include "./Check.hh"
+
+namespace {
+
+// A GPU that finishes frames when told to, or at once when waited on.
+struct FakeCompletion : Engine::CompletionSource {
+    uint64_t done = 0;
+    uint32_t waits = 0;
+
+    uint64_t completed() const override {
+        return done;
+    }
+
+    void wait(uint64_t frame) override {
+        waits++;
+        done = std::max(done, frame);
+    }
+};
+
+struct Fixture {
+    std::vector<std::byte> memory;
+    FakeCompletion completion;
+    Engine::UploadRing ring;
+
+    explicit Fixture(size_t capacity)
+    : memory(capacity),
+      ring(std::span<std::byte>(memory), completion) {}
+};
+
+bool inside(const Engine::UploadRing::Allocation& allocation, const std::vector<std::byte>& memory) {
+    return allocation.data == memory.data() + allocation.offset && allocation.offset + allocation.size <= memory.size();
+}
+
+} /* namespace */
+
+TEST(UploadRingAlignsAndPacks) {
+    Fixture f(4096);
+    const auto a = f.ring.allocate(10);
+    const auto b = f.ring.allocate(100, 64);
+    const auto c = f.ring.allocate(1, 1);
+    CHECK(a && b && c);
+    CHECK(a.offset == 0 && a.size == 10);
+    CHECK(b.offset == 64);
+    CHECK(c.offset == 164);
+    CHECK(inside(a, f.memory) && inside(b, f.memory) && inside(c, f.memory));
+
+    const auto ranges = f.ring.frameRanges();
+    CHECK(ranges.size() == 1 && ranges[0].offset == 0 && ranges[0].size == 165);
+    CHECK(f.ring.stats().used == 165);
+}
+
+TEST(UploadRingRejectsImpossibleSizes) {
+    Fixture f(1024);
+    CHECK(!f.ring.allocate(0));
+    CHECK(!f.ring.allocate(1025));
+    CHECK(f.ring.stats().failed == 1);
+    CHECK(f.ring.allocate(1024));
+}
+
+// An allocation that does not fit before the end starts over at offset 0,
+// and the frame's ranges come in two pieces.
+TEST(UploadRingWrapsAround) {
+    Fixture f(1024);
+    CHECK(f.ring.allocate(512));
+    f.ring.endFrame();
+    f.completion.done = 1;
+
+    CHECK(f.ring.allocate(256, 1).offset == 512);
+    const auto wrapped = f.ring.allocate(300, 1);
+    CHECK(wrapped && wrapped.offset == 0);
+    const auto ranges = f.ring.frameRanges();
+    CHECK(ranges.size() == 2);
+    CHECK(ranges[0].offset == 512 && ranges[0].size == 512);
+    CHECK(ranges[1].offset == 0 && ranges[1].size == 300);
+    CHECK(f.completion.waits == 0);
+}
+
+// With the ring full of frames in flight, an allocation waits for the oldest
+// one; the frame being recorded alone filling the ring fails instead.
+TEST(UploadRingWaitsForGPU) {
+    Fixture f(1024);
+    for (int i = 0; i < 4; ++i) {
+        CHECK(f.ring.allocate(256));
+        CHECK(f.ring.endFrame() == uint64_t(i + 1));
+    }
+    CHECK(f.ring.allocate(256));
+    CHECK(f.completion.waits == 1 && f.completion.done == 1);
+    CHECK(f.ring.stats().waits == 1);
+
+    f.completion.done = 4;
+    CHECK(f.ring.allocate(768));
+    CHECK(!f.ring.allocate(1));
+    CHECK(f.ring.stats().failed == 1);
+    CHECK(f.completion.waits == 1);
+}
+
+TEST(UploadRingBoundsFramesInFlight) {
+    Fixture f(1 << 16);
+    for (size_t i = 0; i < Engine::UploadRing::MaxFramesInFlight; ++i) {
+        CHECK(f.ring.allocate(16));
+        f.ring.endFrame();
+    }
+    CHECK(f.completion.waits == 0);
+    f.ring.endFrame();
+    CHECK(f.completion.waits == 1 && f.completion.done == 1);
+}
+
+// Random frames against a GPU that lags behind by a random number of
+// frames: no allocation may overlap one of a frame not yet completed.
+TEST(UploadRingNeverOverlapsLiveFrames) {
+    constexpr size_t Capacity = 8192;
+    Fixture f(Capacity);
+    std::mt19937 random(20);
+    std::uniform_int_distribution<size_t> size(1, 1500), count(0, 6), lag(0, 4), alignment(0, 8);
+
+    struct Live {
+        uint64_t frame;
+        size_t offset, size;
+    };
+    std::vector<Live> live;
+    uint64_t frame = 1;
+    size_t overlaps = 0, failed = 0;
+    for (int i = 0; i < 5000; ++i) {
+        for (size_t n = count(random); n > 0; --n) {
+            const size_t align = size_t(1) << alignment(random);
+            const auto allocation = f.ring.allocate(size(random), align);
+            if (!allocation) {
+                failed++;
+                continue;
+            }
+            CHECK(allocation.offset % align == 0 && inside(allocation, f.memory));
+            std::erase_if(live, [&](const Live& l) { return l.frame <= f.completion.done; });
+            for (const auto& l : live) {
+                overlaps += allocation.offset < l.offset + l.size && l.offset < allocation.offset + allocation.size;
+            }
+            live.push_back(Live{frame, allocation.offset, allocation.size});
+        }
+        CHECK(f.ring.endFrame() == frame);
+        frame++;
+        const size_t behind = lag(random);
+        if (frame > behind + 1) {
+            f.completion.done = std::max(f.completion.done, frame - 1 - behind);
+        }
+    }
+    CHECK(overlaps == 0);
+    CHECK(f.ring.stats().waits > 0);
+    CHECK(failed == f.ring.stats().failed);
+    CHECK(f.ring.stats().highWater <= Capacity);
+}
+
+BENCHMARK(UploadRingAllocate) {
+    Fixture f(1 << 20);
+    Tests::measure("UploadRing allocate + endFrame", 1000000, [&] {
+        const auto allocation = f.ring.allocate(3000);
+        f.completion.done = f.ring.endFrame();
+        return allocation.offset;
+    });
+}